@@ -4,22 +4,67 @@
 
 # Add inputs and outputs from these tool invocations to the build variables
 C_SRCS += \
+../SpinBarrier.c \
 ../Timer.c \
 ../ThreadPool.c \
+../WorkerTeam.c \
+../fixed_solvers.c \
 ../gaussian.c \
-../solve_system.c
+../gaussian_batch.c \
+../gemm.c \
+../gsys.c \
+../huge_pages.c \
+../mixed_solver.c \
+../phase_timing.c \
+../placement.c \
+../precision.c \
+../row_kernels.c \
+../solution_output.c \
+../solve_system.c \
+../text_system.c \
+../tiled.c
 
 C_DEPS += \
+./SpinBarrier.d \
 ./Timer.d \
 ../ThreadPool.d \
+./WorkerTeam.d \
+./fixed_solvers.d \
 ./gaussian.d \
-./solve_system.d
+./gaussian_batch.d \
+./gemm.d \
+./gsys.d \
+./huge_pages.d \
+./mixed_solver.d \
+./phase_timing.d \
+./placement.d \
+./precision.d \
+./row_kernels.d \
+./solution_output.d \
+./solve_system.d \
+./text_system.d \
+./tiled.d
 
 OBJS += \
+./SpinBarrier.o \
 ./Timer.o \
 ../ThreadPool.o \
+./WorkerTeam.o \
+./fixed_solvers.o \
 ./gaussian.o \
-./solve_system.o
+./gaussian_batch.o \
+./gemm.o \
+./gsys.o \
+./huge_pages.o \
+./mixed_solver.o \
+./phase_timing.o \
+./placement.o \
+./precision.o \
+./row_kernels.o \
+./solution_output.o \
+./solve_system.o \
+./text_system.o \
+./tiled.o
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -34,7 +79,7 @@ OBJS += \
 clean: clean--2e-
 
 clean--2e-:
-	-$(RM) ./Timer.d ./Timer.o ./gaussian.d ./gaussian.o ./solve_system.d ./solve_system.o
+	-$(RM) ./SpinBarrier.d ./SpinBarrier.o ./Timer.d ./Timer.o ./WorkerTeam.d ./WorkerTeam.o ./fixed_solvers.d ./fixed_solvers.o ./gaussian.d ./gaussian.o ./gaussian_batch.d ./gaussian_batch.o ./gemm.d ./gemm.o ./gsys.d ./gsys.o ./huge_pages.d ./huge_pages.o ./mixed_solver.d ./mixed_solver.o ./phase_timing.d ./phase_timing.o ./placement.d ./placement.o ./precision.d ./precision.o ./row_kernels.d ./row_kernels.o ./solution_output.d ./solution_output.o ./solve_system.d ./solve_system.o ./text_system.d ./text_system.o ./tiled.d ./tiled.o
 
 .PHONY: clean--2e-
 
@@ -0,0 +1,104 @@
+/*! \file    SpinBarrier.c
+ *  \brief   Implementation of a low-latency thread barrier.
+ */
+
+#include <limits.h>
+#include <sched.h>
+#include <unistd.h>
+#include "SpinBarrier.h"
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+// How long an early thread busy-waits, and then yields, before blocking in the kernel.
+#define SPIN_LIMIT   2000
+#define YIELD_LIMIT  50
+
+//! Tells the processor we are in a spin loop (saves power and helps a sibling hyperthread).
+static inline void cpu_relax( void )
+{
+    #if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause( );
+    #endif
+}
+
+//! Blocks the calling thread as long as *word still holds 'expected.'
+static void block_on( atomic_int *word, int expected )
+{
+    #if defined(__linux__)
+    syscall( SYS_futex, (int *)word, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0 );
+    #else
+    (void)word;
+    (void)expected;
+    sched_yield( );
+    #endif
+}
+
+//! Wakes every thread blocked on *word.
+static void wake_all( atomic_int *word )
+{
+    #if defined(__linux__)
+    syscall( SYS_futex, (int *)word, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0 );
+    #else
+    (void)word;
+    #endif
+}
+
+
+void SpinBarrier_initialize( SpinBarrier *self, int count )
+{
+    long processors = sysconf( _SC_NPROCESSORS_ONLN );
+
+    self->count = count;
+    self->spin_limit = ( processors > 0 && count > processors ) ? 0 : SPIN_LIMIT;
+    atomic_init( &self->remaining, count );
+    atomic_init( &self->waiters, 0 );
+    atomic_init( &self->sense, 0 );
+}
+
+
+void SpinBarrier_destroy( SpinBarrier *self )
+{
+    // Nothing is allocated. This exists for symmetry with pthread_barrier_destroy.
+    (void)self;
+}
+
+
+int SpinBarrier_wait( SpinBarrier *self )
+{
+    // The sense can't change until this thread has arrived, so this is the sense of the episode
+    // this thread is taking part in.
+    int my_sense = atomic_load( &self->sense );
+    int i;
+
+    if( atomic_fetch_sub( &self->remaining, 1 ) == 1 ) {
+        // Last to arrive. Reset the count for the next episode before anyone can be released
+        // into it, then open the barrier.
+        atomic_store( &self->remaining, self->count );
+        atomic_store( &self->sense, !my_sense );
+        if( atomic_load( &self->waiters ) > 0 ) {
+            wake_all( &self->sense );
+        }
+        return SPIN_BARRIER_SERIAL_THREAD;
+    }
+
+    for( i = 0; i < self->spin_limit; ++i ) {
+        if( atomic_load_explicit( &self->sense, memory_order_acquire ) != my_sense ) return 0;
+        cpu_relax( );
+    }
+    for( i = 0; i < YIELD_LIMIT; ++i ) {
+        if( atomic_load_explicit( &self->sense, memory_order_acquire ) != my_sense ) return 0;
+        sched_yield( );
+    }
+
+    // Register as a waiter before the final check of the sense. The last thread stores the sense
+    // before it reads the waiter count, so one of us is sure to see the other.
+    atomic_fetch_add( &self->waiters, 1 );
+    while( atomic_load( &self->sense ) == my_sense ) {
+        block_on( &self->sense, my_sense );
+    }
+    atomic_fetch_sub( &self->waiters, 1 );
+    return 0;
+}
@@ -0,0 +1,56 @@
+/*!
+ * \file    SpinBarrier.h
+ * \brief   Interface to a low-latency thread barrier.
+ *
+ * A SpinBarrier does the same job as a pthread_barrier_t but is tuned for barriers that are
+ * crossed very frequently with only a little work between crossings. A thread that arrives early
+ * first spins, then yields the processor, and only then blocks in the kernel (on Linux, on a
+ * futex). When the threads arrive close together nobody enters the kernel at all.
+ */
+
+#ifndef SPINBARRIER_H
+#define SPINBARRIER_H
+
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! Returned by SpinBarrier_wait to exactly one of the threads released, as with pthreads.
+#define SPIN_BARRIER_SERIAL_THREAD 1
+
+// SpinBarrier class
+// =================
+
+//! A sense-reversing barrier. It is permitted to have multiple barrier objects.
+typedef struct {
+    int         count;                // Number of threads that must arrive to open the barrier.
+    int         spin_limit;           // Number of busy-wait polls before yielding.
+    atomic_int  remaining;            // Number of threads that have not yet arrived.
+    atomic_int  waiters;              // Number of threads blocked in the kernel.
+    _Alignas(64) atomic_int sense;    // Flips each time the barrier opens. Also the futex word.
+} SpinBarrier;
+
+//! Initializes the barrier pointed at by 'self' for use by 'count' threads.
+/*!
+ * If there are more threads than online processors an early thread can only be waiting for a
+ * thread that needs its processor, so in that case the barrier skips busy-waiting entirely.
+ */
+void SpinBarrier_initialize( SpinBarrier *self, int count );
+
+//! Cleans up the barrier pointed at by 'self.' No thread may be waiting on it.
+void SpinBarrier_destroy( SpinBarrier *self );
+
+//! Waits until 'count' threads have called this function.
+/*!
+ * \return SPIN_BARRIER_SERIAL_THREAD for one of the threads (the last to arrive) and zero for
+ * all the others.
+ */
+int SpinBarrier_wait( SpinBarrier *self );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -104,15 +104,18 @@ static void thread_information_destroy( struct ThreadInformation *self )
 }
 
 
-void ThreadPool_initialize( ThreadPool *self )
+void ThreadPool_initialize( ThreadPool *self, int pool_size )
 {
     int i;
 
-    #if defined(__GLIBC__) || defined(__CYGWIN__)
-    self->pool_size = get_nprocs( );
-    #else
-    self->pool_size = pthread_num_processors_np( );
-    #endif
+    self->pool_size = pool_size;
+    if( self->pool_size <= 0 ) {
+        #if defined(__GLIBC__) || defined(__CYGWIN__)
+        self->pool_size = get_nprocs( );
+        #else
+        self->pool_size = pthread_num_processors_np( );
+        #endif
+    }
     sem_init( &self->worker_count, 0, 0 );
     self->thread_information =
         (struct ThreadInformation *)malloc( self->pool_size * sizeof(struct ThreadInformation) );
@@ -31,8 +31,11 @@ typedef struct {
 //! Type used to hold thread ID values in the scope of a particular pool.
 typedef int threadid_t;
 
-//! Initializes the thread pool pointed at by 'self.'
-void ThreadPool_initialize( ThreadPool *self );
+//! Initializes the thread pool pointed at by 'self' with 'pool_size' threads.
+/*!
+ * If pool_size is not positive the pool has one thread for each processor.
+ */
+void ThreadPool_initialize( ThreadPool *self, int pool_size );
 
 //! Cleans up the thread pool pointed at by 'self.'
 /*!
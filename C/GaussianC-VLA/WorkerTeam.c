@@ -0,0 +1,129 @@
+/*! \file    WorkerTeam.c
+ *  \brief   Implementation of a persistent team of worker threads.
+ */
+
+#include <stdlib.h>
+#include "WorkerTeam.h"
+
+#define FALSE 0
+#define TRUE  1
+
+// TeamMember class
+// ================
+
+//! Used by the WorkerTeam class to track one of its threads.
+struct TeamMember {
+    WorkerTeam *team;     // The team this member belongs to.
+    int         index;    // Which element of each round's argument array this member gets.
+    pthread_t   worker;   // The actual thread described by this TeamMember.
+};
+
+
+//! Function executed by each member thread.
+/*!
+ * Members wait here for the round counter to change. Each member then runs the work function on
+ * its own argument and the last one to finish wakes the thread waiting in WorkerTeam_run.
+ */
+static void *member_function( void *arg )
+{
+    struct TeamMember *me = (struct TeamMember *)arg;
+    WorkerTeam *team = me->team;
+    unsigned long last_round = 0;
+    void *( *work_function )( void * );
+    void *argument;
+
+    while( 1 ) {
+        pthread_mutex_lock( &team->lock );
+        while( team->round == last_round && !team->die )
+            pthread_cond_wait( &team->work_ready, &team->lock );
+        if( team->die ) break;
+        last_round    = team->round;
+        work_function = team->work_function;
+        argument      = team->arguments + me->index * team->argument_size;
+        pthread_mutex_unlock( &team->lock );
+
+        work_function( argument );
+
+        pthread_mutex_lock( &team->lock );
+        if( --team->pending == 0 )
+            pthread_cond_signal( &team->work_done );
+        pthread_mutex_unlock( &team->lock );
+    }
+    pthread_mutex_unlock( &team->lock );
+    return NULL;
+}
+
+
+void WorkerTeam_initialize( WorkerTeam *self, int team_size )
+{
+    int i;
+
+    self->team_size     = ( team_size < 1 ) ? 1 : team_size;
+    self->work_function = NULL;
+    self->arguments     = NULL;
+    self->argument_size = 0;
+    self->round         = 0;
+    self->pending       = 0;
+    self->die           = FALSE;
+    pthread_mutex_init( &self->lock, NULL );
+    pthread_cond_init( &self->work_ready, NULL );
+    pthread_cond_init( &self->work_done, NULL );
+
+    // Member 0 is the calling thread, so only the others need threads of their own.
+    self->members =
+        (struct TeamMember *)malloc( ( self->team_size - 1 ) * sizeof( struct TeamMember ) );
+    for( i = 0; i < self->team_size - 1; ++i ) {
+        self->members[i].team  = self;
+        self->members[i].index = i + 1;
+        pthread_create( &self->members[i].worker, NULL, member_function, &self->members[i] );
+    }
+}
+
+
+void WorkerTeam_destroy( WorkerTeam *self )
+{
+    int i;
+
+    // Tell the members to die and wait until they do.
+    pthread_mutex_lock( &self->lock );
+    self->die = TRUE;
+    pthread_cond_broadcast( &self->work_ready );
+    pthread_mutex_unlock( &self->lock );
+    for( i = 0; i < self->team_size - 1; ++i ) {
+        pthread_join( self->members[i].worker, NULL );
+    }
+
+    free( self->members );
+    pthread_mutex_destroy( &self->lock );
+    pthread_cond_destroy( &self->work_ready );
+    pthread_cond_destroy( &self->work_done );
+}
+
+
+int WorkerTeam_count( WorkerTeam *self )
+{
+    return self->team_size;
+}
+
+
+void WorkerTeam_run( WorkerTeam *self, void *( *work_function )( void * ), void *arguments, size_t argument_size )
+{
+    // Publish the round to the members.
+    pthread_mutex_lock( &self->lock );
+    self->work_function = work_function;
+    self->arguments     = (char *)arguments;
+    self->argument_size = argument_size;
+    self->pending       = self->team_size - 1;
+    ++self->round;
+    pthread_cond_broadcast( &self->work_ready );
+    pthread_mutex_unlock( &self->lock );
+
+    // Do our own share while the others do theirs.
+    work_function( arguments );
+
+    // Wait for the rest of the team.
+    pthread_mutex_lock( &self->lock );
+    while( self->pending > 0 )
+        pthread_cond_wait( &self->work_done, &self->lock );
+    pthread_mutex_unlock( &self->lock );
+}
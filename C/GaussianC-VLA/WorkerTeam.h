@@ -0,0 +1,67 @@
+/*!
+ * \file    WorkerTeam.h
+ * \brief   Interface to a persistent team of worker threads.
+ *
+ * A worker team is created once and then handed one round of work after another. Every round
+ * gives each member of the team its own argument and returns only when all members are done, the
+ * same as creating and joining a thread per argument but without paying for thread creation each
+ * time. The team uses POSIX threads as the underlying thread API.
+ */
+
+#ifndef WORKERTEAM_H
+#define WORKERTEAM_H
+
+#include <stddef.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// WorkerTeam class
+// ================
+
+struct TeamMember;
+
+//! Manages a fixed team of threads that execute rounds of work together.
+typedef struct {
+    int    team_size;                // Number of participants, including the calling thread.
+    struct TeamMember *members;      // Points at dynamic array of team_size - 1 TeamMembers.
+    pthread_mutex_t lock;            // Enforce mutual exclusion to the fields below.
+    pthread_cond_t  work_ready;      // Signaled when a new round starts (or the team dies).
+    pthread_cond_t  work_done;       // Signaled when the last member finishes a round.
+    void *( *work_function )( void * );  // Function to execute in the current round...
+    char           *arguments;           // ... using this array of arguments...
+    size_t          argument_size;       // ... each of this size.
+    unsigned long   round;           // Incremented each time a round starts.
+    int             pending;         // Number of members still working on the current round.
+    int             die;             // True if the members are supposed to terminate.
+} WorkerTeam;
+
+//! Initializes the team pointed at by 'self' and starts team_size - 1 threads.
+/*!
+ * The thread that calls WorkerTeam_run is the remaining member of the team, so a team of size 1
+ * starts no threads at all.
+ */
+void WorkerTeam_initialize( WorkerTeam *self, int team_size );
+
+//! Stops the threads of the team pointed at by 'self' and releases its resources.
+void WorkerTeam_destroy( WorkerTeam *self );
+
+//! Return the number of participants in each round.
+int WorkerTeam_count( WorkerTeam *self );
+
+//! Executes one round of work and waits for it to complete.
+/*!
+ * \param work_function Pointer to the function every member is to execute.
+ * \param arguments Pointer to an array of team_size objects. Member h is passed the address of
+ * element h. The calling thread executes element 0 itself.
+ * \param argument_size The size of each element of the arguments array.
+ */
+void WorkerTeam_run( WorkerTeam *self, void *( *work_function )( void * ), void *arguments, size_t argument_size );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,400 @@
+/*!
+ *  \file   benchmark.c
+ *  \brief  Time the solver over a range of sizes, strategies, and thread counts.
+ *
+ * Each system is generated in memory (see SystemGenerator.h), so no input files are needed, and
+ * every solution is checked against the known one. Each combination of size, strategy, and thread
+ * count is solved a few times to warm up and then timed over several repetitions, with a fresh
+ * copy of the system for every solve.
+ *
+ * Usage: benchmark [options]
+ *
+ *   --sizes=N,...        The sizes of the systems (default 500,1000,2000).
+ *   --strategies=S,...   The strategies, by name or menu number (default serial,pthread,barrier,
+ *                        pool). The names are serial, pthread, barrier, pool, blocked, recursive,
+ *                        mixed, and tiled.
+ *   --threads=T,...      The numbers of threads (default the number of processors).
+ *   --warmups=W          Untimed solves before the timed ones (default 1).
+ *   --repetitions=R      Timed solves (default 5).
+ *   --class=NAME         The class of system, as for generate_system (default dense).
+ *   --seed=N             The seed (default 1).
+ *   --csv=PATH           Also write the results as CSV.
+ *   --json=PATH          Also write the results as JSON.
+ *   --packed             Store the rows of the matrix without padding (see
+ *                        gaussian_leading_dimension) to see what the padding is worth.
+ *
+ * The rate is computed from the minimum time, counting 2/3 n^3 floating point operations.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../WorkerTeam.h"
+#include "../gaussian.h"
+#include "../generator/SystemGenerator.h"
+
+// The most sizes, strategies, or thread counts that can be listed.
+#define BENCHMARK_MAX_LIST 64
+
+static const struct {
+    const char *name;
+    int         selection;
+} strategies[] = {
+    { "serial",    1 },
+    { "pthread",   2 },
+    { "barrier",   3 },
+    { "pool",      4 },
+    { "blocked",   5 },
+    { "recursive", 6 },
+    { "mixed",     7 },
+    { "tiled",     8 },
+};
+
+// The results for one combination of size, strategy, and thread count.
+typedef struct {
+    size_t size;
+    int    selection;
+    int    thread_count;
+    enum GaussianResult result;    // The result of the last solve.
+    double minimum;                // Times in milliseconds.
+    double median;
+    double mean;
+    double deviation;
+    double gflops;                 // At the minimum time.
+    double error;                  // Largest difference from the known solution.
+} Measurement;
+
+
+//! Returns the name of a strategy given its menu number.
+static const char *strategy_name( int selection )
+{
+    for( size_t i = 0; i < sizeof( strategies ) / sizeof( strategies[0] ); ++i ) {
+        if( strategies[i].selection == selection ) return strategies[i].name;
+    }
+    return "unknown";
+}
+
+
+//! Converts a strategy given by name or menu number. Returns zero if it is unknown.
+static int parse_strategy( const char *text )
+{
+    for( size_t i = 0; i < sizeof( strategies ) / sizeof( strategies[0] ); ++i ) {
+        if( strcmp( text, strategies[i].name ) == 0 ) return strategies[i].selection;
+    }
+    int selection = atoi( text );
+    return ( selection >= 1 && selection <= 8 ) ? selection : 0;
+}
+
+
+//! Splits a comma separated list into 'items' (at most BENCHMARK_MAX_LIST). Returns the count.
+/*!
+ * The text is modified: the commas are replaced with null characters.
+ */
+static size_t split_list( char *text, char *items[] )
+{
+    size_t count = 0;
+    char  *saved;
+    for( char *item = strtok_r( text, ",", &saved ); item != NULL && count < BENCHMARK_MAX_LIST; item = strtok_r( NULL, ",", &saved ) ) {
+        items[count++] = item;
+    }
+    return count;
+}
+
+
+//! Returns nonzero if 'argument' is "--name=..." and points *value at the text after the '='.
+static int option( const char *argument, const char *name, char **value )
+{
+    size_t length = strlen( name );
+    if( strncmp( argument, name, length ) != 0 || argument[length] != '=' ) return 0;
+    *value = (char *)argument + length + 1;
+    return 1;
+}
+
+
+//! Returns the time in milliseconds from an arbitrary starting point.
+static double now( void )
+{
+    struct timespec time;
+    clock_gettime( CLOCK_MONOTONIC, &time );
+    return time.tv_sec * 1000.0 + time.tv_nsec / 1000000.0;
+}
+
+
+static int compare_doubles( const void *left, const void *right )
+{
+    double l = *(const double *)left;
+    double r = *(const double *)right;
+    return ( l > r ) - ( l < r );
+}
+
+
+//! Solves the system given by a0 and b0 repeatedly with one strategy and summarizes the times.
+/*!
+ * The rows of a0 are lda elements apart, as are the rows of the copies that are solved. Returns
+ * zero, measuring nothing, if the memory for the copies can't be had.
+ */
+static int measure( const SystemGenerator *generator, size_t lda, const double *a0, const double *b0, int selection, int thread_count, int warmups, int repetitions, Measurement *measurement )
+{
+    const size_t size = generator->size;
+    double *a = (double *)aligned_alloc( 64, ( size * lda * sizeof( double ) + 63 ) / 64 * 64 );
+    double *b = (double *)malloc( size * sizeof( double ) );
+    double  times[repetitions];
+    if( a == NULL || b == NULL ) {
+        free( b );
+        free( a );
+        return 0;
+    }
+
+    *measurement = (Measurement){ .size = size, .selection = selection, .thread_count = thread_count };
+    for( int r = -warmups; r < repetitions; ++r ) {
+        memcpy( a, a0, size * lda * sizeof( double ) );
+        memcpy( b, b0, size * sizeof( double ) );
+        double start = now( );
+        measurement->result = gaussian_solve( size, lda, 1, (floating_type (*)[lda])a, (floating_type (*)[1])b, selection, thread_count );
+        double stop = now( );
+        if( measurement->result != gaussian_success ) break;
+        if( r >= 0 ) times[r] = stop - start;
+    }
+
+    if( measurement->result == gaussian_success ) {
+        for( size_t i = 0; i < size; ++i ) {
+            double difference = fabs( b[i] - generator->solution[i] );
+            if( difference > measurement->error ) measurement->error = difference;
+        }
+
+        double sum = 0.0;
+        double squares = 0.0;
+        for( int r = 0; r < repetitions; ++r ) sum += times[r];
+        measurement->mean = sum / repetitions;
+        for( int r = 0; r < repetitions; ++r ) {
+            squares += ( times[r] - measurement->mean ) * ( times[r] - measurement->mean );
+        }
+        measurement->deviation = ( repetitions > 1 ) ? sqrt( squares / ( repetitions - 1 ) ) : 0.0;
+
+        qsort( times, repetitions, sizeof( double ), compare_doubles );
+        measurement->minimum = times[0];
+        measurement->median = ( repetitions % 2 == 1 ) ? times[repetitions / 2]
+                                                       : ( times[repetitions / 2 - 1] + times[repetitions / 2] ) / 2.0;
+        measurement->gflops = 2.0 / 3.0 * size * size * (double)size / ( measurement->minimum * 1.0E6 );
+    }
+    free( b );
+    free( a );
+    return 1;
+}
+
+
+//! Returns a word for the result of a solve.
+static const char *result_text( enum GaussianResult result )
+{
+    switch( result ) {
+    case gaussian_success:    return "ok";
+    case gaussian_error:      return "error";
+    case gaussian_degenerate: return "degenerate";
+    }
+    return "unknown";
+}
+
+
+static void write_csv( FILE *output, const Measurement *measurements, size_t count )
+{
+    fprintf( output, "size,strategy,threads,result,min_ms,median_ms,mean_ms,stddev_ms,gflops,max_error\n" );
+    for( size_t i = 0; i < count; ++i ) {
+        const Measurement *m = &measurements[i];
+        fprintf( output, "%zu,%s,%d,%s,%.3f,%.3f,%.3f,%.3f,%.3f,%.3e\n",
+                 m->size, strategy_name( m->selection ), m->thread_count, result_text( m->result ),
+                 m->minimum, m->median, m->mean, m->deviation, m->gflops, m->error );
+    }
+}
+
+
+static void write_json( FILE *output, const Measurement *measurements, size_t count )
+{
+    fprintf( output, "[\n" );
+    for( size_t i = 0; i < count; ++i ) {
+        const Measurement *m = &measurements[i];
+        fprintf( output, "  { \"size\": %zu, \"strategy\": \"%s\", \"threads\": %d, \"result\": \"%s\", \"min_ms\": %.3f, "
+                         "\"median_ms\": %.3f, \"mean_ms\": %.3f, \"stddev_ms\": %.3f, \"gflops\": %.3f, "
+                         "\"max_error\": %.3e }%s\n",
+                 m->size, strategy_name( m->selection ), m->thread_count, result_text( m->result ),
+                 m->minimum, m->median, m->mean, m->deviation, m->gflops, m->error,
+                 ( i + 1 < count ) ? "," : "" );
+    }
+    fprintf( output, "]\n" );
+}
+
+
+//! Writes the results to the named file with the given writer. Returns nonzero on success.
+static int write_results( const char *path, void ( *writer )( FILE *, const Measurement *, size_t ), const Measurement *measurements, size_t count )
+{
+    FILE *output = fopen( path, "w" );
+    if( output == NULL ) {
+        fprintf( stderr, "Error: Can not open %s.\n", path );
+        return 0;
+    }
+    writer( output, measurements, count );
+    if( fclose( output ) != 0 ) {
+        fprintf( stderr, "Error: Can not write %s.\n", path );
+        return 0;
+    }
+    return 1;
+}
+
+
+int main( int argc, char *argv[] )
+{
+    char  default_sizes[] = "500,1000,2000";
+    char  default_strategies[] = "serial,pthread,barrier,pool";
+    char *size_list = default_sizes;
+    char *strategy_list = default_strategies;
+    char *thread_list = NULL;
+    int   warmups = 1;
+    int   repetitions = 5;
+    enum SystemClass system_class = class_dense;
+    uint64_t seed = 1;
+    const char *csv_path = NULL;
+    const char *json_path = NULL;
+    int   packed = 0;
+    char *value;
+
+    for( int i = 1; i < argc; ++i ) {
+        if( option( argv[i], "--sizes", &value ) )            size_list = value;
+        else if( option( argv[i], "--strategies", &value ) )  strategy_list = value;
+        else if( option( argv[i], "--threads", &value ) )     thread_list = value;
+        else if( option( argv[i], "--warmups", &value ) )     warmups = atoi( value );
+        else if( option( argv[i], "--repetitions", &value ) ) repetitions = atoi( value );
+        else if( option( argv[i], "--seed", &value ) )        seed = strtoull( value, NULL, 10 );
+        else if( option( argv[i], "--csv", &value ) )         csv_path = value;
+        else if( option( argv[i], "--json", &value ) )        json_path = value;
+        else if( strcmp( argv[i], "--packed" ) == 0 )         packed = 1;
+        else if( option( argv[i], "--class", &value ) ) {
+            if( !SystemGenerator_parse_class( value, &system_class ) ) {
+                fprintf( stderr, "Error: Unknown class '%s'.\n", value );
+                return EXIT_FAILURE;
+            }
+        }
+        else {
+            fprintf( stderr, "Usage: benchmark [--sizes=N,...] [--strategies=S,...] [--threads=T,...] [--warmups=W] [--repetitions=R]\n"
+                             "       [--class=NAME] [--seed=N] [--csv=PATH] [--json=PATH] [--packed]\n" );
+            return EXIT_FAILURE;
+        }
+    }
+
+    char  *items[BENCHMARK_MAX_LIST];
+    size_t sizes[BENCHMARK_MAX_LIST];
+    int    selections[BENCHMARK_MAX_LIST];
+    size_t size_count = split_list( size_list, items );
+    for( size_t i = 0; i < size_count; ++i ) {
+        sizes[i] = strtoul( items[i], NULL, 10 );
+        if( sizes[i] == 0 ) {
+            fprintf( stderr, "Error: Bad size '%s'.\n", items[i] );
+            return EXIT_FAILURE;
+        }
+    }
+    size_t strategy_count = split_list( strategy_list, items );
+    for( size_t i = 0; i < strategy_count; ++i ) {
+        selections[i] = parse_strategy( items[i] );
+        if( selections[i] == 0 ) {
+            fprintf( stderr, "Error: Unknown strategy '%s'.\n", items[i] );
+            return EXIT_FAILURE;
+        }
+    }
+    int    thread_counts[BENCHMARK_MAX_LIST] = { gaussian_thread_count( 0 ) };
+    size_t thread_count_count = 1;
+    if( thread_list != NULL ) {
+        thread_count_count = split_list( thread_list, items );
+        for( size_t i = 0; i < thread_count_count; ++i ) {
+            thread_counts[i] = atoi( items[i] );
+            if( thread_counts[i] <= 0 ) {
+                fprintf( stderr, "Error: Bad thread count '%s'.\n", items[i] );
+                return EXIT_FAILURE;
+            }
+        }
+    }
+    if( size_count == 0 || strategy_count == 0 || thread_count_count == 0 || warmups < 0 || repetitions < 1 ) {
+        fprintf( stderr, "Error: Nothing to measure.\n" );
+        return EXIT_FAILURE;
+    }
+
+    WorkerTeam team;
+    WorkerTeam_initialize( &team, gaussian_thread_count( 0 ) );
+
+    Measurement *measurements = (Measurement *)malloc( size_count * strategy_count * thread_count_count * sizeof( Measurement ) );
+    if( measurements == NULL ) {
+        fprintf( stderr, "Error: Not enough memory for the results.\n" );
+        WorkerTeam_destroy( &team );
+        return EXIT_FAILURE;
+    }
+    size_t count = 0;
+    int    skipped = 0;
+
+    printf( "%8s  %-10s %7s %10s %10s %10s %10s %10s %10s\n",
+            "size", "strategy", "threads", "min ms", "median ms", "mean ms", "stddev ms", "GFLOP/s", "max error" );
+    for( size_t s = 0; s < size_count; ++s ) {
+        const size_t size = sizes[s];
+        SystemGenerator generator;
+        if( !SystemGenerator_initialize( &generator, system_class, size, 1, seed ) ) {
+            fprintf( stderr, "Error: Not enough memory for a system of size %zu; skipping it.\n", size );
+            skipped = 1;
+            continue;
+        }
+        const size_t lda = packed ? size : gaussian_leading_dimension( size, sizeof( double ) );
+        double *a0 = (double *)calloc( size * lda, sizeof( double ) );
+        double *b0 = (double *)malloc( size * sizeof( double ) );
+        if( a0 == NULL || b0 == NULL ) {
+            fprintf( stderr, "Error: Not enough memory for a system of size %zu; skipping it.\n", size );
+            free( b0 );
+            free( a0 );
+            SystemGenerator_destroy( &generator );
+            skipped = 1;
+            continue;
+        }
+        SystemGenerator_fill( &generator, &team, a0, b0 );
+
+        // The generator packs the rows. Spread them out from the bottom up, then clear the padding.
+        if( lda != size ) {
+            for( size_t i = size; i-- > 1; ) {
+                memmove( &a0[i * lda], &a0[i * size], size * sizeof( double ) );
+            }
+            for( size_t i = 0; i < size; ++i ) {
+                memset( &a0[i * lda + size], 0, ( lda - size ) * sizeof( double ) );
+            }
+        }
+
+        int have_memory = 1;
+        for( size_t t = 0; t < strategy_count && have_memory; ++t ) {
+            for( size_t c = 0; c < thread_count_count; ++c ) {
+                Measurement *m = &measurements[count];
+                if( !measure( &generator, lda, a0, b0, selections[t], thread_counts[c], warmups, repetitions, m ) ) {
+                    fprintf( stderr, "Error: Not enough memory to solve a system of size %zu; skipping the rest of it.\n", size );
+                    have_memory = 0;
+                    skipped = 1;
+                    break;
+                }
+                ++count;
+                if( m->result == gaussian_success ) {
+                    printf( "%8zu  %-10s %7d %10.3f %10.3f %10.3f %10.3f %10.3f %10.2e\n",
+                            m->size, strategy_name( m->selection ), m->thread_count,
+                            m->minimum, m->median, m->mean, m->deviation, m->gflops, m->error );
+                }
+                else {
+                    printf( "%8zu  %-10s %7d %s\n", m->size, strategy_name( m->selection ), m->thread_count, result_text( m->result ) );
+                }
+                fflush( stdout );
+            }
+        }
+        free( b0 );
+        free( a0 );
+        SystemGenerator_destroy( &generator );
+    }
+    WorkerTeam_destroy( &team );
+
+    int written = 1;
+    if( csv_path != NULL )  written &= write_results( csv_path, write_csv, measurements, count );
+    if( json_path != NULL ) written &= write_results( json_path, write_json, measurements, count );
+    free( measurements );
+    return ( written && !skipped ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
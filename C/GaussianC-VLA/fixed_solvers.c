@@ -0,0 +1,167 @@
+/*!
+ * \file   fixed_solvers.c
+ * \brief  Solvers specialized for small systems of particular sizes.
+ *
+ * C has no templates, so the specializations are made the way the compiler makes them anyway:
+ * the algorithm is written once as an always-inlined function of the size, and each specialized
+ * solver calls it with a constant. After inlining the size is a compile-time constant, the row
+ * operations are unrolled completely, and the matrix lives in a small local array that stays in
+ * the L1 cache instead of behind a row table. The outer loops are left alone; unrolling them
+ * as well made the 16 x 16 solver twice as slow and gained nothing measurable for the others.
+ */
+
+#include <math.h>
+
+#include "fixed_solvers.h"
+
+// For profiling, it is best for all functions to be public.
+#define PRIVATE // static
+#define PUBLIC
+
+// The largest specialized size. It bounds the local arrays.
+#define FIXED_MAX 16
+
+//! Solves a system with n unknowns and rhs_count driving vectors. O(n^3 + n^2 m)
+/*!
+ * This is only ever called with a constant n. It eliminates on a local copy of the matrix and
+ * carries the driving vectors along, as the serial strategy once did. No multipliers are kept, so
+ * every row operation can cover the whole row: the elements left of the pivot are zero in the
+ * pivot row and stay as they are in the others. That gives every loop constant bounds.
+ */
+__attribute__(( always_inline ))
+static inline enum GaussianResult fixed_template( const size_t n, size_t lda, size_t rhs_count, const floating_type * restrict a, floating_type * restrict b )
+{
+    floating_type u[FIXED_MAX][FIXED_MAX];
+    floating_type temp, m;
+    size_t        i, j, k, c;
+
+    _Pragma( "GCC unroll 16" )
+    for( i = 0; i < n; ++i ) {
+        _Pragma( "GCC unroll 16" )
+        for( j = 0; j < n; ++j ) {
+            u[i][j] = a[i * lda + j];
+        }
+    }
+
+    for( i = 0; i < n; ++i ) {
+
+        // Find the row with the largest value of |u[j][i]|, j = i, ..., n - 1
+        k = i;
+        m = fabs( u[i][i] );
+        for( j = i + 1; j < n; ++j ) {
+            if( fabs( u[j][i] ) > m ) {
+                k = j;
+                m = fabs( u[j][i] );
+            }
+        }
+
+        // Check for |u[k][i]| zero.
+        // TODO: The value 1.0E-6 is arbitrary. A more disciplined value should be used.
+        if( m <= 1.0E-6 ) {
+            return gaussian_degenerate;
+        }
+
+        // Exchange row i and row k, if necessary.
+        if( k != i ) {
+            _Pragma( "GCC unroll 16" )
+            for( j = 0; j < n; ++j ) {
+                temp = u[i][j];
+                u[i][j] = u[k][j];
+                u[k][j] = temp;
+            }
+
+            // Exchange corresponding rows of b.
+            for( c = 0; c < rhs_count; ++c ) {
+                temp = b[i * rhs_count + c];
+                b[i * rhs_count + c] = b[k * rhs_count + c];
+                b[k * rhs_count + c] = temp;
+            }
+        }
+
+        // Subtract multiples of row i from subsequent rows.
+        for( j = i + 1; j < n; ++j ) {
+            m = u[j][i] / u[i][i];
+            _Pragma( "GCC unroll 16" )
+            for( k = 0; k < n; ++k ) {
+                u[j][k] -= m * u[i][k];
+            }
+            for( c = 0; c < rhs_count; ++c ) {
+                b[j * rhs_count + c] -= m * b[i * rhs_count + c];
+            }
+        }
+    }
+
+    // Back substitution. Counting down is safe here because i is compared with a constant.
+    for( i = n; i-- > 0; ) {
+        m = 1.0 / u[i][i];
+        for( c = 0; c < rhs_count; ++c ) {
+            temp = b[i * rhs_count + c];
+            _Pragma( "GCC unroll 16" )
+            for( j = i + 1; j < n; ++j ) {
+                temp -= u[i][j] * b[j * rhs_count + c];
+            }
+            b[i * rhs_count + c] = temp * m;
+        }
+    }
+    return gaussian_success;
+}
+
+// The specializations. To add a size, add a solver here and a case to each function below.
+PRIVATE enum GaussianResult fixed_solve_3( size_t lda, size_t rhs_count, const floating_type * restrict a, floating_type * restrict b )
+{
+    return fixed_template( 3, lda, rhs_count, a, b );
+}
+
+PRIVATE enum GaussianResult fixed_solve_4( size_t lda, size_t rhs_count, const floating_type * restrict a, floating_type * restrict b )
+{
+    return fixed_template( 4, lda, rhs_count, a, b );
+}
+
+PRIVATE enum GaussianResult fixed_solve_6( size_t lda, size_t rhs_count, const floating_type * restrict a, floating_type * restrict b )
+{
+    return fixed_template( 6, lda, rhs_count, a, b );
+}
+
+PRIVATE enum GaussianResult fixed_solve_8( size_t lda, size_t rhs_count, const floating_type * restrict a, floating_type * restrict b )
+{
+    return fixed_template( 8, lda, rhs_count, a, b );
+}
+
+PRIVATE enum GaussianResult fixed_solve_16( size_t lda, size_t rhs_count, const floating_type * restrict a, floating_type * restrict b )
+{
+    return fixed_template( 16, lda, rhs_count, a, b );
+}
+
+
+PUBLIC int fixed_solver_available( size_t size )
+{
+    switch( size ) {
+    case 3:
+    case 4:
+    case 6:
+    case 8:
+    case 16:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+
+PUBLIC enum GaussianResult fixed_solve( size_t size, size_t lda, size_t rhs_count, const floating_type * restrict a, floating_type * restrict b )
+{
+    switch( size ) {
+    case 3:
+        return fixed_solve_3( lda, rhs_count, a, b );
+    case 4:
+        return fixed_solve_4( lda, rhs_count, a, b );
+    case 6:
+        return fixed_solve_6( lda, rhs_count, a, b );
+    case 8:
+        return fixed_solve_8( lda, rhs_count, a, b );
+    case 16:
+        return fixed_solve_16( lda, rhs_count, a, b );
+    default:
+        return gaussian_error;
+    }
+}
@@ -0,0 +1,28 @@
+/*!
+ * \file   fixed_solvers.h
+ * \brief  Interface to solvers specialized for small systems of particular sizes.
+ *
+ * Each solver is the generic algorithm compiled with the size as a constant, so the compiler can
+ * unroll the row operations and work out the indexes at compile time. gaussian_solve uses them
+ * automatically for systems of the sizes listed here.
+ */
+
+#ifndef FIXED_SOLVERS_H
+#define FIXED_SOLVERS_H
+
+#include <stddef.h>
+
+#include "gaussian.h"
+
+//! Returns nonzero if there is a solver specialized for systems with 'size' unknowns.
+int fixed_solver_available( size_t size );
+
+//! Solves a system of a size for which fixed_solver_available returns nonzero.
+/*!
+ * The arguments are as for gaussian_solve, with a and b as size x size and size x rhs_count
+ * matrices in row-major order, the rows of a lda elements apart. The matrix of coefficients is
+ * not modified.
+ */
+enum GaussianResult fixed_solve( size_t size, size_t lda, size_t rhs_count, const floating_type * restrict a, floating_type * restrict b );
+
+#endif
@@ -10,213 +10,210 @@
 #include <string.h>
 #include <pthread.h>
 #include <stdio.h>
+#if defined(__GLIBC__) || defined(__CYGWIN__)
+#include <sys/sysinfo.h>  // For get_nprocs( ).
+#endif
 
+#include "SpinBarrier.h"
 #include "ThreadPool.h"
+#include "WorkerTeam.h"
+#include "fixed_solvers.h"
 #include "gaussian.h"
+#include "gemm.h"
+#include "mixed_solver.h"
+#include "phase_timing.h"
+#include "placement.h"
+#include "row_kernels.h"
+#include "tiled.h"
 
 // For profiling, it is best for all functions to be public.
 #define PRIVATE // static
 #define PUBLIC
 
-#define PROCESSOR_COUNT 8
+// Number of columns in each panel factored by the blocked strategy and in each block of rows
+// solved by the block substitution. Compile with -DBLOCK_SIZE=n to tune it for a particular cache
+// hierarchy.
+#ifndef BLOCK_SIZE
+#define BLOCK_SIZE 64
+#endif
 
-//! Does the elimination step of reducing the system. O(n^3)
-PRIVATE enum GaussianResult serial_elimination( size_t size, floating_type (* restrict a)[size], floating_type * restrict b )
-{
-    //floating_type *temp_array = (floating_type *)malloc( size * sizeof(floating_type) );
-    floating_type  temp_array[size];
-    size_t         i, j, k;
-    floating_type  temp, m;
-
-    for( i = 0; i < size - 1; ++i ) {
+// Nonzero if the barrier strategy pins its threads and keeps each row on the same thread.
+static int placement_enabled = 0;
 
-        // Find the row with the largest value of |a[j][i]|, j = i, ..., n - 1
-        k = i;
-        m = fabs( a[i][i] );
-        for( j = i + 1; j < size; ++j ) {
-            if( fabs( a[j][i] ) > m ) {
-                k = j;
-                m = fabs( a[j][i] );
-            }
-        }
+PUBLIC int gaussian_thread_count( int thread_count )
+{
+    if( thread_count > 0 ) return thread_count;
 
-        // Check for |a[k][i]| zero.
-        // TODO: The value 1.0E-6 is arbitrary. A more disciplined value should be used.
-        if( fabs( a[k][i] ) <= 1.0E-6 ) {
-            //free( temp_array );
-            return gaussian_degenerate;
-        }
+    #if defined(__GLIBC__) || defined(__CYGWIN__)
+    return get_nprocs( );
+    #else
+    return pthread_num_processors_np( );
+    #endif
+}
 
-        // Exchange row i and row k, if necessary.
-        if( k != i ) {
-            memcpy( temp_array, a[i], size * sizeof( floating_type ) );
-            memcpy( a[i], a[k], size * sizeof( floating_type ) );
-            memcpy( a[k], temp_array, size * sizeof( floating_type ) );
-
-            // Exchange corresponding elements of b.
-            temp = b[i];
-            b[i] = b[k];
-            b[k] = temp;
-        }
+PUBLIC size_t gaussian_leading_dimension( size_t size, size_t element_size )
+{
+    if( element_size == 0 || 64 % element_size != 0 ) return size;
 
-        // Subtract multiples of row i from subsequent rows.
-        if (i % 2 == 0) {
-            for( j = i + 1; j < size; ++j ) {
-                m = a[j][i] / a[i][i];
-                for( k = 0; k < size; ++k ) {
-                    a[j][k] -= m * a[i][k];
-                }
-                b[j] -= m * b[i];
-            }
-        } else {
-            for( j = size - 1; j > i; --j ) {
-                m = a[j][i] / a[i][i];
-                for( k = 0; k < size; ++k ) {
-                    a[j][k] -= m * a[i][k];
-                }
-                b[j] -= m * b[i];
-            }
-        }
-    }
-    //free( temp_array );
-    return gaussian_success;
+    // Round up to whole lines, then to an odd number of them.
+    size_t line = 64 / element_size;
+    size_t lines = ( size + line - 1 ) / line;
+    if( lines % 2 == 0 ) ++lines;
+    return lines * line;
 }
 
-// Structure to define the data processed by a single thread.
-struct PThreadWorkUnit {
-    floating_type *a;
-    floating_type *b;
-    size_t current;
-    size_t start;
-    size_t stop;
+// Structure to define the columns of the driving matrix processed by a single thread.
+struct SubstitutionWorkUnit {
+    floating_type *const *a;
+    floating_type *const *b;
     size_t size;
+    size_t first;
+    size_t last;
 };
 
-void * p_thread_chunk_elimination( void *arg ) {
-    struct PThreadWorkUnit *unit = (struct PThreadWorkUnit *)arg;
-
-    const size_t size = unit->size;
-    const size_t current = unit->current;
-    const size_t start = unit->start;
-    const size_t stop = unit->stop;
+//! Solves L Y = B in place for columns [first, last) of B, BLOCK_SIZE rows at a time. O(n^2 m)
+/*!
+ * Each block of rows first receives the contributions of all the rows above it in a single
+ * matrix-matrix product and is then finished with a small triangular solve.
+ */
+PRIVATE void block_forward_substitution( size_t size, floating_type *const *a, floating_type *const *b, size_t first, size_t last )
+{
+    size_t         start, stop;
+    size_t         i, j;
 
-    floating_type (* restrict a)[size] = unit->a;
-    floating_type * restrict b = unit->b;
-    size_t         j, k;
-    floating_type  m;
+    for( start = 0; start < size; start = stop ) {
+        stop = ( size - start < BLOCK_SIZE ) ? size : start + BLOCK_SIZE;
+        gemm_update( stop - start, last - first, start, &a[start], 0, b, first, &b[start], first );
 
-    // Subtract multiples of row i from subsequent rows.
-    if (start % 2 == 0) {
-        for( j = start; j < stop; ++j ) {
-            m = a[j][current] / a[current][current];
-            for( k = 0; k < size; ++k ) {
-                a[j][k] -= m * a[current][k];
-            }
-            b[j] -= m * b[current];
-        }
-    } else {
-        for( j = stop - 1; j >= start; --j ) {
-            m = a[j][current] / a[current][current];
-            for( k = 0; k < size; ++k ) {
-                a[j][k] -= m * a[current][k];
+        for( i = start + 1; i < stop; ++i ) {
+            for( j = start; j < i; ++j ) {
+                row_axpy( last - first, a[i][j], &b[j][first], &b[i][first] );
             }
-            b[j] -= m * b[current];
         }
-
     }
-
-    return NULL;
 }
 
-enum GaussianResult p_thread_elimination( size_t size, floating_type (* restrict a)[size], floating_type * restrict b ) {
-
-    int processor_count = PROCESSOR_COUNT;
-    floating_type  temp_array[size];
+//! Solves U X = Y in place for columns [first, last) of Y, BLOCK_SIZE rows at a time. O(n^2 m)
+/*!
+ * This mirrors block_forward_substitution, working up from the bottom of the matrix.
+ */
+PRIVATE void block_back_substitution( size_t size, floating_type *const *a, floating_type *const *b, size_t first, size_t last )
+{
+    size_t         start, stop;
     size_t         i, j, k;
-    floating_type  temp, m;
-    size_t  chunk_size;
+    floating_type  m;
 
-    for( i = 0; i < size - 1; ++i ) {
+    for( stop = size; stop > 0; stop = start ) {
+        start = ( stop < BLOCK_SIZE ) ? 0 : stop - BLOCK_SIZE;
+        gemm_update( stop - start, last - first, size - stop, &a[start], stop, &b[stop], first, &b[start], first );
 
-        // Find the row with the largest value of |a[j][i]|, j = i, ..., n - 1
-        k = i;
-        m = fabs( a[i][i] );
-        for( j = i + 1; j < size; ++j ) {
-            if( fabs( a[j][i] ) > m ) {
-                k = j;
-                m = fabs( a[j][i] );
+        // We can't count i down from stop - 1 to start (inclusive) because it is unsigned.
+        for( i = stop; i-- > start; ) {
+            for( j = i + 1; j < stop; ++j ) {
+                row_axpy( last - first, a[i][j], &b[j][first], &b[i][first] );
+            }
+            m = a[i][i];
+            for( k = first; k < last; ++k ) {
+                b[i][k] /= m;
             }
         }
+    }
+}
 
-        // Check for |a[k][i]| zero.
-        // TODO: The value 1.0E-6 is arbitrary. A more disciplined value should be used.
-        if( fabs( a[k][i] ) <= 1.0E-6 ) {
-            //free( temp_array );
-            return gaussian_degenerate;
-        }
-
-        // Exchange row i and row k, if necessary.
-        if( k != i ) {
-            memcpy( temp_array, a[i], size * sizeof( floating_type ) );
-            memcpy( a[i], a[k], size * sizeof( floating_type ) );
-            memcpy( a[k], temp_array, size * sizeof( floating_type ) );
-
-            // Exchange corresponding elements of b.
-            temp = b[i];
-            b[i] = b[k];
-            b[k] = temp;
-        }
-
-        struct PThreadWorkUnit *ranges =
-            (struct PThreadWorkUnit *)malloc( processor_count * sizeof(struct PThreadWorkUnit) );
-        pthread_t *threads =
-            (pthread_t *)malloc( processor_count * sizeof(pthread_t) );
+void * substitution_work( void *arg ) {
+    struct SubstitutionWorkUnit *unit = (struct SubstitutionWorkUnit *)arg;
 
-        // Split the problem.
-        size_t problem_size = ( size - ( i + 1 ));
-        chunk_size = problem_size / processor_count;
-        for( size_t x = 0; x < processor_count; ++x ) {
-            ranges[x].a = a;
-            ranges[x].b = b;
-            ranges[x].start = i + 1 + x * chunk_size;
-            ranges[x].stop = ranges[x].start + chunk_size;
-            ranges[x].current = i;
-            ranges[x].size = size;
-        }
-        // The following line assigns the remainder elements to the last thread.
-        ranges[processor_count - 1].stop = size;
+    block_forward_substitution( unit->size, unit->a, unit->b, unit->first, unit->last );
+    block_back_substitution( unit->size, unit->a, unit->b, unit->first, unit->last );
+    return NULL;
+}
 
-        // Start the worker threads.
-        for( int h = 0; h < processor_count; ++h ) {
-            pthread_create( &threads[h], NULL, p_thread_chunk_elimination, &ranges[h] );
-        }
+//! Solves L U X = Y in place for a driving matrix Y with more than one column. O(n^2 m)
+/*!
+ * The columns are divided among a team of threads. They are independent, so the threads never
+ * wait for each other.
+ */
+PRIVATE void block_substitution( size_t size, floating_type *const *rows, size_t rhs_count, floating_type *work, int thread_count )
+{
+    size_t i;
 
-        for( int h = 0; h < processor_count; ++h ) {
-            pthread_join( threads[h], NULL );
-        }
+    floating_type **work_rows = (floating_type **)malloc( size * sizeof( floating_type * ) );
+    for( i = 0; i < size; ++i ) {
+        work_rows[i] = &work[i * rhs_count];
+    }
 
-        // Release dynamic memory.
-        free( threads );
-        free( ranges );
+    // Give each thread whole GEMM_NR wide panels of columns. Small systems aren't worth the cost
+    // of starting a team.
+    size_t panel_count = ( rhs_count + GEMM_NR - 1 ) / GEMM_NR;
+    int unit_count = ( panel_count < (size_t)thread_count ) ? (int)panel_count : thread_count;
+    if( size < BLOCK_SIZE ) unit_count = 1;
+    size_t chunk_size = ( panel_count + unit_count - 1 ) / unit_count * GEMM_NR;
+
+    struct SubstitutionWorkUnit *units =
+        (struct SubstitutionWorkUnit *)malloc( unit_count * sizeof(struct SubstitutionWorkUnit) );
+    for( int h = 0; h < unit_count; ++h ) {
+        units[h].a = rows;
+        units[h].b = work_rows;
+        units[h].size = size;
+        units[h].first = ( h * chunk_size < rhs_count ) ? h * chunk_size : rhs_count;
+        units[h].last = ( units[h].first + chunk_size < rhs_count ) ? units[h].first + chunk_size : rhs_count;
+    }
 
+    if( unit_count == 1 ) {
+        substitution_work( &units[0] );
+    }
+    else {
+        WorkerTeam team;
+        WorkerTeam_initialize( &team, unit_count );
+        WorkerTeam_run( &team, substitution_work, units, sizeof(struct SubstitutionWorkUnit) );
+        WorkerTeam_destroy( &team );
     }
 
-    return gaussian_success;
+    free( units );
+    free( work_rows );
 }
 
 
+// The serial, p_thread, and blocked strategies and the substitutions are written once for every
+// precision in precision_template.h. Double gets the vectorized row kernels, the packed GEMM, and
+// the threaded block substitution above.
+#define PRECISION_TYPE floating_type
+#define PRECISION_SUFFIX double
+#define PRECISION_AXPY row_axpy
+#define PRECISION_PIVOT_SEARCH row_pivot_search
+#define PRECISION_GEMM gemm_update
+#define PRECISION_BLOCK_SUBSTITUTION block_substitution
+#define PRECISION_ENGINE_ONLY
+#include "precision_template.h"
+
+
 // Structure to define the data processed by a single thread.
 struct BarrierWorkUnit {
-    floating_type *a;
-    floating_type *b;
-    floating_type *temp_array;
+    floating_type **a;
     size_t size;
     size_t offset;
+    int    team_size;                // The number of units.
+    struct BarrierWorkUnit *team;    // All units of one solve, indexed by offset.
+    SpinBarrier *iteration_barrier;  // Shared by all units of one solve.
+    SpinBarrier *work_barrier;
+    size_t pivot_row;                // Best pivot candidate among this unit's rows...
+    floating_type pivot_value;       // ... and its magnitude (-1 if the unit has no rows).
+    GaussianProfile *profile;        // NULL unless the solve is being timed.
     enum GaussianResult result;
 };
 
-pthread_barrier_t iteration_barrier;
-pthread_barrier_t work_barrier;
+//! Computes the range of rows [*start, *stop) of [first, size) handled by thread 'offset' of 'count.'
+static void barrier_chunk( size_t first, size_t size, size_t offset, int count, size_t *start, size_t *stop )
+{
+    size_t chunk_size = ( size - first ) / count;
+
+    *start = first + offset * chunk_size;
+    if (offset == count - 1) {
+        *stop = size;
+    } else {
+        *stop = *start + chunk_size;
+    }
+}
 
 void * barrier_work( void *arg) {
     struct BarrierWorkUnit *unit = (struct BarrierWorkUnit *)arg;
@@ -224,131 +221,355 @@ void * barrier_work( void *arg) {
     const size_t size = unit->size;
     const size_t offset = unit->offset;
 
-    floating_type (* restrict a)[size] = unit->a;
-    floating_type * restrict b = unit->b;
-    floating_type (* restrict temp_array)[size] = unit->temp_array;
+    floating_type **a = unit->a;
+    struct BarrierWorkUnit *team = unit->team;
 
+    floating_type *row;
     size_t         start, stop;
-    size_t         problem_size, chunk_size;
     size_t         i, j, k;
-    floating_type  temp, m;
+    floating_type  m;
+    size_t         best_row;
+    floating_type  best_value;
+    double         time = phase_clock( unit->profile );
+
+    // Each thread scans its own rows of the first column for a pivot candidate. After that, the
+    // candidates for column i + 1 are found while the rows are updated in iteration i.
+    barrier_chunk( 0, size, offset, unit->team_size, &start, &stop );
+    unit->pivot_row = start;
+    unit->pivot_value = -1.0;
+    for( j = start; j < stop; ++j ) {
+        if( fabs( a[j][0] ) > unit->pivot_value ) {
+            unit->pivot_row = j;
+            unit->pivot_value = fabs( a[j][0] );
+        }
+    }
+    time = phase_charge( unit->profile, offset, phase_pivot_search, time );
 
     for( i = 0; i < size - 1; ++i ) {
-        if ( pthread_barrier_wait( &iteration_barrier ) == PTHREAD_BARRIER_SERIAL_THREAD ) {
-            // Find the row with the largest value of |a[j][i]|, j = i, ..., n - 1
-            k = i;
-            m = fabs( a[i][i] );
-            for( j = i + 1; j < size; ++j ) {
-                if( fabs( a[j][i] ) > m ) {
-                    k = j;
-                    m = fabs( a[j][i] );
-                }
-            }
-
-            // Check for |a[k][i]| zero.
-            // TODO: The value 1.0E-6 is arbitrary. A more disciplined value should be used.
-            if( fabs( a[k][i] ) <= 1.0E-6 ) {
-                //free( temp_array );
-                unit-> result = gaussian_degenerate;
-                return NULL;
-            }
-
-            // Exchange row i and row k, if necessary.
-            if( k != i ) {
-                memcpy( temp_array, a[i], size * sizeof( floating_type ) );
-                memcpy( a[i], a[k], size * sizeof( floating_type ) );
-                memcpy( a[k], temp_array, size * sizeof( floating_type ) );
-
-                // Exchange corresponding elements of b.
-                temp = b[i];
-                b[i] = b[k];
-                b[k] = temp;
+        SpinBarrier_wait( unit->iteration_barrier );
+        time = phase_charge( unit->profile, offset, phase_synchronization, time );
+
+        // Combine the candidates. Every thread does this on the same data and so comes up with
+        // the same pivot, which saves a barrier. Ties go to the lowest row, as in the serial code.
+        k = team[0].pivot_row;
+        m = team[0].pivot_value;
+        for( int h = 1; h < unit->team_size; ++h ) {
+            if( team[h].pivot_value > m ) {
+                k = team[h].pivot_row;
+                m = team[h].pivot_value;
             }
+        }
 
+        // Check for |a[k][i]| zero. All threads reach the same conclusion.
+        // TODO: The value 1.0E-6 is arbitrary. A more disciplined value should be used.
+        if( m <= 1.0E-6 ) {
+            unit-> result = gaussian_degenerate;
+            return NULL;
+        }
+        time = phase_charge( unit->profile, offset, phase_pivot_search, time );
+
+        // Exchange row i and row k, if necessary. Only their pointers in the row table move, so
+        // one thread does it while the others go on to the work barrier.
+        if( k != i && offset == 0 ) {
+            row = a[i];
+            a[i] = a[k];
+            a[k] = row;
         }
+        time = phase_charge( unit->profile, offset, phase_row_swap, time );
 
-        pthread_barrier_wait( &work_barrier );
+        SpinBarrier_wait( unit->work_barrier );
+        time = phase_charge( unit->profile, offset, phase_synchronization, time );
 
-        problem_size = ( size - ( i + 1 ));
-        chunk_size = problem_size / PROCESSOR_COUNT;
-        start = i + 1 + offset * chunk_size;
-        if (offset == PROCESSOR_COUNT - 1) {
-            stop = size;
-        } else {
-            stop = start + chunk_size;
-        }
-        // Subtract multiples of row i from subsequent rows.
+        barrier_chunk( i + 1, size, offset, unit->team_size, &start, &stop );
+        best_row = start;
+        best_value = -1.0;
+
+        // Record the multipliers and subtract multiples of row i from subsequent rows, noting the
+        // best pivot candidate in column i + 1 as each row is finished.
         if (i % 2 == 0) {
             for( j = start; j < stop; ++j ) {
-                m = a[j][i] / a[i][i];
-                for( k = 0; k < size; ++k ) {
-                    a[j][k] -= m * a[i][k];
+                m = a[j][i] /= a[i][i];
+                row_axpy( size - i - 1, m, &a[i][i + 1], &a[j][i + 1] );
+                if( fabs( a[j][i + 1] ) > best_value ) {
+                    best_row = j;
+                    best_value = fabs( a[j][i + 1] );
                 }
-                b[j] -= m * b[i];
             }
         } else {
             for( j = stop - 1; j >= start; --j ) {
-                m = a[j][i] / a[i][i];
-                for( k = 0; k < size; ++k ) {
-                    a[j][k] -= m * a[i][k];
+                m = a[j][i] /= a[i][i];
+                row_axpy( size - i - 1, m, &a[i][i + 1], &a[j][i + 1] );
+                if( fabs( a[j][i + 1] ) >= best_value ) {
+                    best_row = j;
+                    best_value = fabs( a[j][i + 1] );
                 }
-                b[j] -= m * b[i];
             }
         }
+
+        // Publish the candidate once, to keep the cache line it shares with other units quiet.
+        unit->pivot_row = best_row;
+        unit->pivot_value = best_value;
+        time = phase_charge( unit->profile, offset, phase_row_update, time );
     }
 
     unit-> result = gaussian_success;
     return NULL;
 }
 
+// Structure to define the rows owned by a single thread when the data is placed.
+struct PlacedWorkUnit {
+    floating_type **a;               // The row table. Only member 0 changes it.
+    floating_type  *base;            // Row r of the matrix starts at base + r * lda.
+    size_t         *position;        // position[r] is the place of row r in the table.
+    size_t size;
+    size_t lda;
+    size_t band_rows;                // Rows are owned in bands of this many (see placement.h).
+    int    member;
+    int    team_size;                // The number of units.
+    struct PlacedWorkUnit *team;     // All units of one solve, indexed by member.
+    SpinBarrier *barrier;            // Shared by all units of one solve.
+    GaussianProfile *profile;        // NULL unless the solve is being timed.
+    enum GaussianResult result;
+    _Alignas(64) struct {
+        size_t        row;           // Best pivot candidate among this unit's rows...
+        floating_type value;         // ... and its magnitude (-1 if the unit has no rows).
+    } candidates[2];                 // For even and odd columns, so one can be written while the other is read.
+};
+
+//! Eliminates with the bands of rows of the matrix owned by one thread.
+/*!
+ * Rows never change hands, and the bands start and end on page boundaries, so after the first
+ * touch (see placement.h) a thread only ever writes memory local to it. A thread finds its rows
+ * by their place in memory rather than in the row table, so it doesn't need the table at all;
+ * member 0 keeps the table up to date on the side.
+ * That leaves one barrier per column. The candidates for the next pivot are kept in two slots so
+ * a thread that runs ahead can publish its candidate without disturbing one that is still reading.
+ */
+void * placed_barrier_work( void *arg ) {
+    struct PlacedWorkUnit *unit = (struct PlacedWorkUnit *)arg;
+
+    const size_t size = unit->size;
+    const size_t lda = unit->lda;
+    const size_t band_rows = unit->band_rows;
+    const int    member = unit->member;
+    const int    team_size = unit->team_size;
+    floating_type *const base = unit->base;
+    struct PlacedWorkUnit *team = unit->team;
+
+    floating_type *row, *pivot;
+    size_t         i, j, k, place, best_row;
+    size_t         count = 0;
+    floating_type  m, best_value;
+    double         time;
+
+    placement_pin( member, team_size );
+    time = phase_clock( unit->profile );
+
+    // The rows this thread has yet to finish, by their place in memory.
+    size_t *mine = (size_t *)malloc( ( size / team_size + 2 * band_rows ) * sizeof( size_t ) );
+    for( j = 0; j < size; ++j ) {
+        if( placement_owner( j, band_rows, team_size ) == member ) mine[count++] = j;
+    }
+
+    best_row = 0;
+    best_value = -1.0;
+    for( j = 0; j < count; ++j ) {
+        if( fabs( base[mine[j] * lda] ) > best_value ) {
+            best_row = mine[j];
+            best_value = fabs( base[mine[j] * lda] );
+        }
+    }
+    unit->candidates[0].row = best_row;
+    unit->candidates[0].value = best_value;
+    time = phase_charge( unit->profile, member, phase_pivot_search, time );
+
+    for( i = 0; i < size - 1; ++i ) {
+        SpinBarrier_wait( unit->barrier );
+        time = phase_charge( unit->profile, member, phase_synchronization, time );
+
+        // Combine the candidates. Every thread comes up with the same pivot. Ties go to the row
+        // that comes first in memory.
+        k = team[0].candidates[i % 2].row;
+        m = team[0].candidates[i % 2].value;
+        for( int h = 1; h < team_size; ++h ) {
+            if( team[h].candidates[i % 2].value > m ||
+                ( team[h].candidates[i % 2].value == m && team[h].candidates[i % 2].row < k ) ) {
+                k = team[h].candidates[i % 2].row;
+                m = team[h].candidates[i % 2].value;
+            }
+        }
+
+        // Check for |a[k][i]| zero. All threads reach the same conclusion.
+        // TODO: The value 1.0E-6 is arbitrary. A more disciplined value should be used.
+        if( m <= 1.0E-6 ) {
+            unit->result = gaussian_degenerate;
+            free( mine );
+            return NULL;
+        }
+        pivot = base + k * lda;
+        time = phase_charge( unit->profile, member, phase_pivot_search, time );
+
+        // The pivot row is finished, so its owner drops it. Member 0 moves it to place i in the
+        // table.
+        if( placement_owner( k, band_rows, team_size ) == member ) {
+            for( j = 0; mine[j] != k; ++j ) ;
+            mine[j] = mine[--count];
+        }
+        if( member == 0 ) {
+            place = unit->position[k];
+            row = unit->a[i];
+            unit->a[i] = unit->a[place];
+            unit->a[place] = row;
+            unit->position[(size_t)( row - base ) / lda] = place;
+            unit->position[k] = i;
+        }
+        time = phase_charge( unit->profile, member, phase_row_swap, time );
+
+        // Record the multipliers and subtract multiples of the pivot row from this thread's rows,
+        // noting the best pivot candidate in column i + 1 as each row is finished.
+        best_row = 0;
+        best_value = -1.0;
+        for( j = 0; j < count; ++j ) {
+            row = base + mine[( i % 2 == 0 ) ? j : count - 1 - j] * lda;
+            m = row[i] /= pivot[i];
+            row_axpy( size - i - 1, m, &pivot[i + 1], &row[i + 1] );
+            if( fabs( row[i + 1] ) > best_value ) {
+                best_row = (size_t)( row - base ) / lda;
+                best_value = fabs( row[i + 1] );
+            }
+        }
+        unit->candidates[( i + 1 ) % 2].row = best_row;
+        unit->candidates[( i + 1 ) % 2].value = best_value;
+        time = phase_charge( unit->profile, member, phase_row_update, time );
+    }
+
+    free( mine );
+    unit->result = gaussian_success;
+    return NULL;
+}
+
+//! Does the elimination step of reducing the system with pinned threads that keep their rows. O(n^3)
+PRIVATE enum GaussianResult placed_barrier_elimination( size_t size, size_t lda, floating_type **a, int thread_count )
+{
+    enum GaussianResult return_code = gaussian_success;
+    SpinBarrier barrier;
+
+    // The table is in memory order on entry (see lu_factor).
+    size_t *position = (size_t *)malloc( size * sizeof( size_t ) );
+    for( size_t r = 0; r < size; ++r ) {
+        position[r] = r;
+    }
+
+    struct PlacedWorkUnit *units =
+        (struct PlacedWorkUnit *)aligned_alloc( 64, thread_count * sizeof(struct PlacedWorkUnit) );
+    pthread_t *threads =
+        (pthread_t *)malloc( thread_count * sizeof(pthread_t) );
+
+    SpinBarrier_initialize( &barrier, thread_count );
+    phase_team( phase_current_profile, thread_count );
+
+    for( int h = 0; h < thread_count; ++h ) {
+        units[h].a = a;
+        units[h].base = a[0];
+        units[h].position = position;
+        units[h].size = size;
+        units[h].lda = lda;
+        units[h].band_rows = placement_band_rows( lda * sizeof( floating_type ) );
+        units[h].member = h;
+        units[h].team_size = thread_count;
+        units[h].team = units;
+        units[h].barrier = &barrier;
+        units[h].profile = phase_current_profile;
+
+        pthread_create( &threads[h], NULL, placed_barrier_work, &units[h] );
+    }
+
+    for( int h = 0; h < thread_count; ++h ) {
+        pthread_join( threads[h], NULL );
+        if (units[h].result == gaussian_degenerate) {
+            return_code = gaussian_degenerate;
+        }
+    }
+
+    // Release dynamic memory.
+    SpinBarrier_destroy( &barrier );
+    free( threads );
+    free( units );
+    free( position );
+    return return_code;
+}
+
 //! Does the elimination step of reducing the system. O(n^3)
-PRIVATE enum GaussianResult barrier_elimination( size_t size, floating_type (* restrict a)[size], floating_type * restrict b )
+/*!
+ * The rows are only reached through the table, except when the data is placed; then the rows
+ * are found in memory, lda elements apart.
+ */
+PRIVATE enum GaussianResult barrier_elimination( size_t size, size_t lda, floating_type **a, int thread_count )
 {
-    //floating_type *temp_array = (floating_type *)malloc( size * sizeof(floating_type) );
-    floating_type  temp_array[size];
+    enum GaussianResult return_code = gaussian_success;
+
+    if( placement_enabled ) {
+        return placed_barrier_elimination( size, lda, a, thread_count );
+    }
+
+    // The barriers belong to this call, so concurrent solves don't interfere with each other.
+    SpinBarrier iteration_barrier;
+    SpinBarrier work_barrier;
 
     struct BarrierWorkUnit *units =
-            (struct BarrierWorkUnit *)malloc( PROCESSOR_COUNT * sizeof(struct BarrierWorkUnit) );
+            (struct BarrierWorkUnit *)malloc( thread_count * sizeof(struct BarrierWorkUnit) );
     pthread_t *threads =
-        (pthread_t *)malloc( PROCESSOR_COUNT * sizeof(pthread_t) );
+        (pthread_t *)malloc( thread_count * sizeof(pthread_t) );
 
-    pthread_barrier_init( &iteration_barrier, NULL, PROCESSOR_COUNT );
-    pthread_barrier_init( &work_barrier, NULL, PROCESSOR_COUNT );
+    SpinBarrier_initialize( &iteration_barrier, thread_count );
+    SpinBarrier_initialize( &work_barrier, thread_count );
+    phase_team( phase_current_profile, thread_count );
 
     // Create a thread for each CPU and set it working on its work unit.
-    for( int offset = 0; offset < PROCESSOR_COUNT; ++offset ) {
+    for( int offset = 0; offset < thread_count; ++offset ) {
         units[offset].a = a;
-        units[offset].b = b;
-        units[offset].temp_array = temp_array;
         units[offset].size = size;
         units[offset].offset = offset;
+        units[offset].team_size = thread_count;
+        units[offset].team = units;
+        units[offset].iteration_barrier = &iteration_barrier;
+        units[offset].work_barrier = &work_barrier;
+        units[offset].profile = phase_current_profile;
 
         pthread_create( &threads[offset], NULL, barrier_work, &units[offset]);
     }
 
 
-    for( int h = 0; h < PROCESSOR_COUNT; ++h ) {
+    for( int h = 0; h < thread_count; ++h ) {
         pthread_join( threads[h], NULL );
         if (units[h].result == gaussian_degenerate) {
-            return gaussian_degenerate;
+            return_code = gaussian_degenerate;
         }
     }
 
     // Release dynamic memory.
+    SpinBarrier_destroy( &iteration_barrier );
+    SpinBarrier_destroy( &work_barrier );
     free( threads );
     free( units );
-    return gaussian_success;
+    return return_code;
 }
 
 
 // Structure to define the data processed by a single thread.
 struct PoolWorkUnit {
-    floating_type *a;
-    floating_type *b;
+    floating_type **a;
     size_t current;
     size_t start;
     size_t stop;
     size_t size;
+    floating_type *base;         // NULL unless the data is placed. Then row r starts at base + r * lda...
+    size_t lda;
+    size_t band_rows;            // ... and the unit only updates the rows in its bands (see placement.h).
+    GaussianProfile *profile;    // NULL unless the solve is being timed.
+    int member;                  // This unit's place among the units of a round.
+    int team_size;               // The number of units in a round.
+    double update_time;          // Time taken by the unit.
 };
 
 void * pool_chunk_elimination( void *arg ) {
@@ -359,77 +580,87 @@ void * pool_chunk_elimination( void *arg ) {
     const size_t start = unit->start;
     const size_t stop = unit->stop;
 
-    floating_type (* restrict a)[size] = unit->a;
-    floating_type * restrict b = unit->b;
-    size_t         j, k;
+    floating_type **a = unit->a;
+    size_t         j, n;
     floating_type  m;
-
-    // Subtract multiples of row i from subsequent rows.
-    if (start % 2 == 0) {
+    double         time;
+
+    // The units of a round are handed to the pool threads in order, so pool thread h always runs
+    // member h. It is pinned the first time, which keeps it next to the memory of its bands.
+    static _Thread_local int pinned_member = -1;
+    if( unit->base != NULL && pinned_member != unit->member ) {
+        placement_pin( unit->member, unit->team_size );
+        pinned_member = unit->member;
+    }
+    time = phase_clock( unit->profile );
+
+    // Record the multipliers and subtract multiples of row i from subsequent rows.
+    if( unit->base != NULL ) {
+        // The rows of the unit's bands, wherever the pivoting has put them in the table.
+        for( n = start; n < stop; ++n ) {
+            j = ( current % 2 == 0 ) ? n : stop - 1 - ( n - start );
+            if( placement_owner( (size_t)( a[j] - unit->base ) / unit->lda, unit->band_rows, unit->team_size ) != unit->member ) continue;
+            m = a[j][current] /= a[current][current];
+            row_axpy( size - current - 1, m, &a[current][current + 1], &a[j][current + 1] );
+        }
+    } else if (start % 2 == 0) {
         for( j = start; j < stop; ++j ) {
-            m = a[j][current] / a[current][current];
-            for( k = 0; k < size; ++k ) {
-                a[j][k] -= m * a[current][k];
-            }
-            b[j] -= m * b[current];
+            m = a[j][current] /= a[current][current];
+            row_axpy( size - current - 1, m, &a[current][current + 1], &a[j][current + 1] );
         }
     } else {
         for( j = stop - 1; j >= start; --j ) {
-            m = a[j][current] / a[current][current];
-            for( k = 0; k < size; ++k ) {
-                a[j][k] -= m * a[current][k];
-            }
-            b[j] -= m * b[current];
+            m = a[j][current] /= a[current][current];
+            row_axpy( size - current - 1, m, &a[current][current + 1], &a[j][current + 1] );
         }
 
     }
 
+    unit->update_time = phase_charge( unit->profile, unit->member, phase_row_update, time ) - time;
     return NULL;
 }
 
-enum GaussianResult pool_elimination( size_t size, floating_type (* restrict a)[size], floating_type * restrict b ) {
+enum GaussianResult pool_elimination( size_t size, size_t lda, floating_type **a, int thread_count ) {
 
-    int processor_count = 8;
-    floating_type  temp_array[size];
-    size_t         i, j, k;
-    floating_type  temp, m;
+    int processor_count = thread_count;
+    floating_type *row;
+    size_t         i, k;
     size_t  chunk_size;
 
-    ThreadPool pool;
-    ThreadPool_initialize(&pool);
+    // When the data is placed each unit keeps the bands of rows it was given by
+    // gaussian_allocate_placed, as in placed_barrier_work. The table is in memory order on entry
+    // (see lu_factor).
+    floating_type *base = placement_enabled ? a[0] : NULL;
+    size_t band_rows = placement_band_rows( lda * sizeof( floating_type ) );
 
+    // There is a thread in the pool for each unit of a round, so starting them never waits.
+    ThreadPool pool;
+    ThreadPool_initialize(&pool, processor_count);
 
+    GaussianProfile *profile = phase_current_profile;
+    double time = phase_clock( profile );
+    phase_team( profile, processor_count );
 
     for( i = 0; i < size - 1; ++i ) {
 
         // Find the row with the largest value of |a[j][i]|, j = i, ..., n - 1
-        k = i;
-        m = fabs( a[i][i] );
-        for( j = i + 1; j < size; ++j ) {
-            if( fabs( a[j][i] ) > m ) {
-                k = j;
-                m = fabs( a[j][i] );
-            }
-        }
+        k = row_pivot_search( a, i, i, size );
 
         // Check for |a[k][i]| zero.
         // TODO: The value 1.0E-6 is arbitrary. A more disciplined value should be used.
         if( fabs( a[k][i] ) <= 1.0E-6 ) {
-            //free( temp_array );
+            ThreadPool_destroy(&pool);
             return gaussian_degenerate;
         }
+        time = phase_charge( profile, 0, phase_pivot_search, time );
 
-        // Exchange row i and row k, if necessary.
+        // Exchange row i and row k, if necessary. Only their pointers in the row table move.
         if( k != i ) {
-            memcpy( temp_array, a[i], size * sizeof( floating_type ) );
-            memcpy( a[i], a[k], size * sizeof( floating_type ) );
-            memcpy( a[k], temp_array, size * sizeof( floating_type ) );
-
-            // Exchange corresponding elements of b.
-            temp = b[i];
-            b[i] = b[k];
-            b[k] = temp;
+            row = a[i];
+            a[i] = a[k];
+            a[k] = row;
         }
+        time = phase_charge( profile, 0, phase_row_swap, time );
 
         struct PoolWorkUnit *ranges =
             (struct PoolWorkUnit *)malloc( processor_count * sizeof(struct PoolWorkUnit) );
@@ -441,11 +672,22 @@ enum GaussianResult pool_elimination( size_t size, floating_type (* restrict a)[
         chunk_size = problem_size / processor_count;
         for( size_t x = 0; x < processor_count; ++x ) {
             ranges[x].a = a;
-            ranges[x].b = b;
             ranges[x].start = i + 1 + x * chunk_size;
             ranges[x].stop = ranges[x].start + chunk_size;
             ranges[x].current = i;
             ranges[x].size = size;
+            ranges[x].base = base;
+            ranges[x].lda = lda;
+            ranges[x].band_rows = band_rows;
+            ranges[x].profile = profile;
+            ranges[x].member = (int)x;
+            ranges[x].team_size = processor_count;
+
+            // Placed units look over all the rows and pick out their own.
+            if( base != NULL ) {
+                ranges[x].start = i + 1;
+                ranges[x].stop = size;
+            }
         }
         // The following line assigns the remainder elements to the last thread.
         ranges[processor_count - 1].stop = size;
@@ -459,6 +701,16 @@ enum GaussianResult pool_elimination( size_t size, floating_type (* restrict a)[
             ThreadPool_result(&pool, threads[h]);
         }
 
+        // Whatever part of the round a unit didn't spend on its rows went to handing out work
+        // and waiting.
+        if( profile != NULL ) {
+            double now = phase_clock( profile );
+            for( int h = 0; h < processor_count; ++h ) {
+                phase_add( profile, h, phase_synchronization, now - time - ranges[h].update_time );
+            }
+            time = now;
+        }
+
         // Release dynamic memory.
         free( threads );
         free( ranges );
@@ -471,65 +723,291 @@ enum GaussianResult pool_elimination( size_t size, floating_type (* restrict a)[
 }
 
 
-//! Does the back substitution step of solving the system. O(n^2)
-PRIVATE enum GaussianResult back_substitution( size_t size, floating_type (* restrict a)[size], floating_type * restrict b )
+//! Factors columns [start, start + width) below row start by splitting them in half recursively.
+/*!
+ * The left half is factored, the top of the right half is solved against it, the rest of the
+ * right half is updated with a matrix-matrix product, and then the right half is factored. Each
+ * level of the recursion works on blocks half the size of the level above, so some level always
+ * fits in each level of the cache, whatever the sizes of those caches happen to be.
+ */
+PRIVATE enum GaussianResult recursive_factor( size_t size, floating_type **a, size_t start, size_t width )
 {
-    floating_type sum;
-    size_t        i, j;
-    size_t        counter;
+    size_t half;
+    enum GaussianResult return_code;
 
-    // We can't count i down from size - 1 to zero (inclusive) because it is unsigned.
-    for( counter = 0; counter < size; ++counter ) {
-        i = ( size - 1 ) - counter;
-        // TODO: The value 1.0E-6 is arbitrary. A more disciplined value should be used.
-        if( fabs( a[i][i] ) <= 1.0E-6 ) {
-            return gaussian_degenerate;
-        }
+    if( width == 1 ) {
+        return precision_panel_factor_double( size, a, start, width );
+    }
+
+    half = width / 2;
+    return_code = recursive_factor( size, a, start, half );
+    if( return_code != gaussian_success ) {
+        return return_code;
+    }
+
+    double time = phase_clock( phase_current_profile );
+    precision_triangular_update_double( size, a, start, half, start + half, start + width );
+    precision_trailing_update_double( size, a, start + half, size, start + half, start + width, start, start + half );
+    phase_charge( phase_current_profile, 0, phase_row_update, time );
+
+    return recursive_factor( size, a, start + half, width - half );
+}
+
+//! Does the elimination step of reducing the system with a recursive LU factorization. O(n^3)
+PRIVATE enum GaussianResult recursive_elimination( size_t size, floating_type **a )
+{
+    phase_team( phase_current_profile, 1 );
+    return recursive_factor( size, a, 0, size );
+}
+
+
+//! Does the elimination step of reducing the system on a tile-major copy of the matrix. O(n^3)
+/*!
+ * The rows are copied into tiles (see tiled.h), factored there, and copied back. Row exchanges
+ * in the tiles move data, so the factors come back in their final order; each row of them is put
+ * in the memory of the original row it came from and the row table is pointed at it, which
+ * leaves the table as the other strategies leave it. The table must be in memory order on entry
+ * (see lu_factor). The time spent copying counts as row exchanges.
+ */
+PRIVATE enum GaussianResult tiled_elimination( size_t size, size_t lda, floating_type **a, int thread_count )
+{
+    const size_t   count = tiled_count( size );
+    floating_type *base = a[0];
+    size_t         i, k;
+
+    floating_type *tiles = (floating_type *)aligned_alloc( 64, count * count * TILE_SIZE * TILE_SIZE * sizeof( floating_type ) );
+    size_t *pivots = (size_t *)malloc( size * sizeof( size_t ) );
+    size_t *order = (size_t *)malloc( size * sizeof( size_t ) );
+    if( tiles == NULL || pivots == NULL || order == NULL ) {
+        free( order );
+        free( pivots );
+        free( tiles );
+        return gaussian_error;
+    }
+
+    double time = phase_clock( phase_current_profile );
+    tiled_from_rows( size, a, tiles );
+    phase_charge( phase_current_profile, 0, phase_row_swap, time );
+
+    enum GaussianResult return_code = tiled_factor( size, tiles, pivots, thread_count );
+    if( return_code == gaussian_success ) {
 
-        sum = b[i];
-        for( j = i + 1; j < size; ++j ) {
-            sum -= a[i][j] * b[j];
+        // Replay the exchanges to find where each row of the factors came from.
+        for( i = 0; i < size; ++i ) {
+            order[i] = i;
         }
-        b[i] = sum / a[i][i];
+        for( i = 0; i < size; ++i ) {
+            k = order[i];
+            order[i] = order[pivots[i]];
+            order[pivots[i]] = k;
+        }
+        for( i = 0; i < size; ++i ) {
+            a[i] = base + order[i] * lda;
+        }
+
+        time = phase_clock( phase_current_profile );
+        tiled_to_rows( size, tiles, a );
+        phase_charge( phase_current_profile, 0, phase_row_swap, time );
     }
-    return gaussian_success;
+
+    free( order );
+    free( pivots );
+    free( tiles );
+    return return_code;
 }
 
 
-PUBLIC enum GaussianResult gaussian_solve( size_t size, floating_type (* restrict a)[size], floating_type * restrict b, int selection )
+//! Factors the size x size matrix stored row after row, lda elements apart, in 'factors'.
+/*!
+ * On success rows[i] points at row i of the factors and pivots[i] is the index of that row in
+ * the original matrix. Either way, the rows themselves are never moved. Everything past the
+ * row table works through the table alone, so the padding is never touched.
+ */
+PRIVATE enum GaussianResult lu_factor( size_t size, size_t lda, floating_type *factors, floating_type **rows, size_t *pivots, int selection, int thread_count )
 {
-    // We can deal with a 1x1 system, but not an empty system.
-    if( size == 0 ) return gaussian_error;
     enum GaussianResult return_code;
+    size_t i;
+
+    for( i = 0; i < size; ++i ) {
+        rows[i] = &factors[i * lda];
+    }
 
     switch (selection)
     {
     // Serial
     case 1:
     case '1':
-        return_code = serial_elimination( size, a, b );
+        return_code = precision_elimination_double( size, rows );
         break;
     // p_thread
     case 2:
     case '2':
-        return_code = p_thread_elimination( size, a, b );
+        return_code = precision_threaded_elimination_double( size, rows, thread_count );
         break;
     // Barrier
     case 3:
     case '3':
-        return_code = barrier_elimination( size, a, b );
+        return_code = barrier_elimination( size, lda, rows, thread_count );
         break;
     // Thread Pool
     case 4:
     case '4':
-        return_code = pool_elimination( size, a, b );
+        return_code = pool_elimination( size, lda, rows, thread_count );
+        break;
+    // Blocked
+    case 5:
+    case '5':
+        return_code = precision_blocked_elimination_double( size, rows );
+        break;
+    // Recursive
+    case 6:
+    case '6':
+        return_code = recursive_elimination( size, rows );
+        break;
+    // Tiled
+    case 8:
+    case '8':
+        return_code = tiled_elimination( size, lda, rows, thread_count );
         break;
 
     default:
-        return gaussian_error;
+        return_code = gaussian_error;
+        break;
+    }
+
+    for( i = 0; i < size; ++i ) {
+        pivots[i] = (size_t)( rows[i] - factors ) / lda;
+    }
+    return return_code;
+}
+
+PUBLIC void gaussian_set_placement( int enabled )
+{
+    placement_enabled = enabled;
+}
+
+
+PUBLIC void *gaussian_allocate_placed( size_t size, size_t lda, size_t element_size, int thread_count, const void *source, size_t source_lda )
+{
+    if( source != NULL && ( source_lda < size || source_lda > lda ) ) return NULL;
+    return placement_allocate( size, lda * element_size, gaussian_thread_count( thread_count ), source, source_lda * element_size );
+}
+
+
+PUBLIC void gaussian_free_placed( void *a, size_t size, size_t lda, size_t element_size )
+{
+    placement_free( a, size, lda * element_size );
+}
+
+
+PUBLIC enum GaussianResult gaussian_factor( size_t size, size_t lda, floating_type (* restrict a)[lda], int selection, int thread_count, GaussianLU *lu )
+{
+    lu->size = 0;
+    lu->factors = NULL;
+    lu->rows = NULL;
+    lu->pivots = NULL;
+
+    // We can deal with a 1x1 system, but not an empty system.
+    if( size == 0 || lda < size ) return gaussian_error;
+
+    // The copy is padded whatever the layout of a. Its size is a whole number of cache lines.
+    size_t factors_lda = gaussian_leading_dimension( size, sizeof( floating_type ) );
+    lu->size = size;
+    lu->thread_count = gaussian_thread_count( thread_count );
+    lu->factors = (floating_type *)aligned_alloc( 64, size * factors_lda * sizeof( floating_type ) );
+    lu->rows = (floating_type **)malloc( size * sizeof( floating_type * ) );
+    lu->pivots = (size_t *)malloc( size * sizeof( size_t ) );
+    for( size_t i = 0; i < size; ++i ) {
+        memcpy( &lu->factors[i * factors_lda], a[i], size * sizeof( floating_type ) );
+    }
+
+    enum GaussianResult return_code = lu_factor( size, factors_lda, lu->factors, lu->rows, lu->pivots, selection, lu->thread_count );
+    if( return_code != gaussian_success ) {
+        gaussian_lu_destroy( lu );
+    }
+    return return_code;
+}
+
+
+PUBLIC enum GaussianResult gaussian_solve_factored( const GaussianLU *lu, size_t rhs_count, floating_type (* restrict b)[rhs_count] )
+{
+    if( lu->size == 0 ) return gaussian_error;
+
+    // The scratch space belongs to the call so several threads can share one factorization.
+    return precision_lu_substitution_double( lu->size, lu->rows, lu->pivots, rhs_count, &b[0][0], lu->thread_count );
+}
+
+
+PUBLIC void gaussian_lu_destroy( GaussianLU *lu )
+{
+    free( lu->pivots );
+    free( lu->rows );
+    free( lu->factors );
+    lu->size = 0;
+    lu->factors = NULL;
+    lu->rows = NULL;
+    lu->pivots = NULL;
+}
+
+
+//! Returns non-zero if gaussian_solve accepts 'selection'. See solve_system's menu.
+PRIVATE int valid_selection( int selection )
+{
+    return ( selection >= 1 && selection <= 8 ) || ( selection >= '1' && selection <= '8' );
+}
+
+
+PUBLIC enum GaussianResult gaussian_solve( size_t size, size_t lda, size_t rhs_count, floating_type (* restrict a)[lda], floating_type (* restrict b)[rhs_count], int selection, int thread_count )
+{
+    enum GaussianResult return_code;
+
+    // We can deal with a 1x1 system, but not an empty system.
+    if( size == 0 || lda < size ) return gaussian_error;
+    if( !valid_selection( selection ) ) return gaussian_error;
+
+    GaussianProfile *profile = phase_current_profile;
+    double time = phase_clock( profile );
+
+    // A few small sizes have their own specialized solvers. At those sizes none of the
+    // strategies can compete with them, so any valid selection is solved the same way.
+    if( fixed_solver_available( size ) ) {
+        phase_team( profile, 1 );
+        return_code = fixed_solve( size, lda, rhs_count, &a[0][0], &b[0][0] );
+
+        // The specialized solvers are unrolled into one piece, so all of their time counts as
+        // row updates.
+        phase_charge( profile, 0, phase_row_update, time );
+    }
+
+    // Mixed precision leaves a and b alone unless it succeeds. When it fails the system is solved
+    // again in double precision with the blocked strategy, which also reports degenerate systems.
+    else if( ( selection == 7 || selection == '7' ) &&
+             mixed_solve( size, lda, rhs_count, &a[0][0], &b[0][0] ) == gaussian_success ) {
+        return_code = gaussian_success;
     }
 
-    if( return_code == gaussian_success )
-        return_code = back_substitution( size, a, b );
+    else {
+        if( selection == 7 || selection == '7' ) selection = 5;
+
+        // This is gaussian_factor followed by gaussian_solve_factored, except that a is factored
+        // in place rather than copied. The strategies reach the rows of a through a table of
+        // pointers. Pivoting reorders the table instead of copying rows around, so on return the
+        // rows of a are in no particular order.
+        floating_type **rows = (floating_type **)malloc( size * sizeof( floating_type * ) );
+        size_t *pivots = (size_t *)malloc( size * sizeof( size_t ) );
+
+        thread_count = gaussian_thread_count( thread_count );
+        return_code = lu_factor( size, lda, &a[0][0], rows, pivots, selection, thread_count );
+        if( return_code == gaussian_success )
+            return_code = precision_lu_substitution_double( size, rows, pivots, rhs_count, &b[0][0], thread_count );
+
+        free( pivots );
+        free( rows );
+    }
+
+    if( profile != NULL ) {
+        profile->solve_count += 1;
+        profile->elapsed += phase_clock( profile ) - time;
+    }
     return return_code;
 }
@@ -14,7 +14,8 @@
 #error C99-style variable length arrays are required, but are not supported by this compiler.
 #endif
 
-// Change this type alias to change the data type of the matrix elements.
+// The data type of the matrix elements for every strategy. Other precisions can be chosen at run
+// time with gaussian_solve_precision (below).
 typedef double floating_type;
 
 enum GaussianResult {
@@ -25,14 +26,155 @@ enum GaussianResult {
 
 //! Gaussian Elimination solver.
 /*!
+ * \param lda The leading dimension of a: the distance, in elements, from the start of one row to
+ * the start of the next. It must be at least size. See gaussian_leading_dimension.
+ * \param rhs_count The number of driving vectors, which are solved together.
  * \param a A pointer to the matrix of coefficients in row-major order.
- * \param b A pointer to the driving vector.
+ * \param b A pointer to the driving vectors as the columns of a size x rhs_count matrix in
+ * row-major order.
+ * \param selection The strategy to use, as numbered in solve_system's menu.
+ * \param thread_count The number of threads the threaded strategies use. If it is not positive
+ * they use one thread for each processor.
  * \returns gaussian_success if the system is solved.
  *
- * This function solves the system in place. If it is successful, the driving vector is replaced
- * with the solution. If this function is not successful, the matrix of coefficients and the
- * driving vector may be in a partially modified state.
+ * This function solves the system in place. If it is successful, the driving vectors are
+ * replaced with the solutions. If this function is not successful, the matrix of coefficients
+ * and the driving vectors may be in a partially modified state. Systems of a few small sizes
+ * (see fixed_solvers.h) are solved by specialized code whatever the selection, but a selection
+ * that names no strategy is still rejected with gaussian_error. Selection 7
+ * factors in single precision and refines the solution in double (see mixed_solver.h); it is
+ * only available here, not in gaussian_factor.
  */
-enum GaussianResult gaussian_solve( size_t size, floating_type (* restrict a)[size], floating_type * restrict b, int selection );
+enum GaussianResult gaussian_solve( size_t size, size_t lda, size_t rhs_count, floating_type (* restrict a)[lda], floating_type (* restrict b)[rhs_count], int selection, int thread_count );
+
+//! Returns a good leading dimension for a size x size matrix with elements of element_size bytes.
+/*!
+ * Each row is padded to a whole number of 64 byte cache lines, and to an odd number of them. With
+ * a power of two stride, such as 1024 doubles, every element of a column falls in the same cache
+ * set and the column walks of the pivot search and the updates thrash the cache; an odd number
+ * of lines spreads a column over all the sets. A matrix that starts on a 64 byte boundary then
+ * has every row on one. Returns size if element_size doesn't divide 64.
+ */
+size_t gaussian_leading_dimension( size_t size, size_t element_size );
+
+//! Returns the number of threads a solve uses when asked for thread_count.
+/*!
+ * That is thread_count itself if it is positive and the number of processors if it is not.
+ */
+int gaussian_thread_count( int thread_count );
+
+//! Selects whether the barrier (3) and thread pool (4) strategies place their data for NUMA.
+/*!
+ * When enabled, their threads are pinned to processors (see placement.h) and each keeps the same
+ * page-aligned bands of rows for the whole solve, so the rows stay in the memory local to the
+ * thread that updates them, provided they were put there to begin with by
+ * gaussian_allocate_placed. The other strategies ignore it. Off by default.
+ */
+void gaussian_set_placement( int enabled );
+
+//! Allocates a size x size matrix with each row in the memory local to the thread that will own it.
+/*!
+ * Rows are lda elements apart in the block. Each thread gets whole pages. They are copied from
+ * 'source' if it is not NULL, and zeroed otherwise, by those threads. The rows of source are
+ * source_lda elements apart; it may be as small as size, so a packed matrix is padded as it is
+ * placed, but no larger than lda. The thread count must be the one later given to
+ * gaussian_solve. Returns NULL if the memory can't be had. Release it with gaussian_free_placed.
+ */
+void *gaussian_allocate_placed( size_t size, size_t lda, size_t element_size, int thread_count, const void *source, size_t source_lda );
+
+//! Releases a matrix allocated by gaussian_allocate_placed.
+void gaussian_free_placed( void *a, size_t size, size_t lda, size_t element_size );
+
+//! The LU factors of a matrix, computed with partial pivoting.
+/*!
+ * L has a unit diagonal that is not stored. Its multipliers are held below the diagonal of the
+ * factors and U is held on and above it. Use the functions below rather than the members.
+ */
+typedef struct {
+    size_t          size;      // Number of rows (and columns) in the factored matrix.
+    floating_type  *factors;   // The rows of the factors, in the order of the original matrix and padded.
+    floating_type **rows;      // rows[i] is row i of the factors.
+    size_t         *pivots;    // Row i of the factors came from row pivots[i] of the matrix.
+    int             thread_count;  // The number of threads used to factor and to substitute.
+} GaussianLU;
+
+//! Factors a matrix so that systems using it can be solved later. O(n^3)
+/*!
+ * \param lda The leading dimension of a, as for gaussian_solve.
+ * \param a A pointer to the matrix of coefficients in row-major order. It is not modified.
+ * \param selection The elimination strategy to use, as for gaussian_solve.
+ * \param thread_count The number of threads, as for gaussian_solve. Solving with the factors
+ * uses the same number.
+ * \param lu The factorization. On success it must eventually be released with
+ * gaussian_lu_destroy. On failure there is nothing to release.
+ * \returns gaussian_success if the matrix is not degenerate.
+ */
+enum GaussianResult gaussian_factor( size_t size, size_t lda, floating_type (* restrict a)[lda], int selection, int thread_count, GaussianLU *lu );
+
+//! Solves the system with the factored matrix and driving vectors b. O(n^2) per vector.
+/*!
+ * The driving vectors are the columns of b, laid out as for gaussian_solve. If it is successful,
+ * they are replaced with the solutions. The factorization is not modified, so any number of
+ * threads may use it at the same time.
+ */
+enum GaussianResult gaussian_solve_factored( const GaussianLU *lu, size_t rhs_count, floating_type (* restrict b)[rhs_count] );
+
+//! Releases the memory held by a factorization.
+void gaussian_lu_destroy( GaussianLU *lu );
+
+//! Solves a batch of small systems that all have the same size. O(n^3) per system.
+/*!
+ * \param count The number of systems in the batch.
+ * \param a The coefficients as a structure of arrays: a[i][j][s] is element (i, j) of system s.
+ * \param b The driving vectors in the same style: b[i][s] is element i of the vector of system s.
+ * \param results If not NULL, an array of count elements that receives the result of each system.
+ * \returns gaussian_success if every system is solved, gaussian_degenerate if any is degenerate.
+ *
+ * Neighbouring systems are solved together, one per SIMD lane, which is far faster than calling
+ * gaussian_solve on each small system in turn. Large batches are divided among threads. The
+ * driving vectors are replaced with the solutions (zero for degenerate systems) and the
+ * coefficients are overwritten.
+ */
+enum GaussianResult gaussian_solve_batch( size_t size, size_t count, floating_type (* restrict a)[size][count], floating_type (* restrict b)[count], enum GaussianResult * restrict results );
+
+// The precisions the solver supports. floating_type (double) has every strategy; the others are
+// solved by one serial engine instantiated for each type (see precision_template.h).
+enum GaussianPrecision {
+    precision_float,
+    precision_double,
+    precision_long_double,
+    precision_float128      // Only where the compiler provides __float128.
+};
+
+#if defined(__SIZEOF_FLOAT128__)
+#define GAUSSIAN_HAVE_FLOAT128
+#endif
+
+//! Gaussian Elimination solvers for the other precisions. The arguments are as for gaussian_solve.
+/*!
+ * Only the serial (1), p_thread (2), and blocked (5) strategies are available. Any other selection
+ * returns gaussian_error.
+ */
+enum GaussianResult gaussian_solve_float( size_t size, size_t lda, size_t rhs_count, float (* restrict a)[lda], float (* restrict b)[rhs_count], int selection, int thread_count );
+enum GaussianResult gaussian_solve_long_double( size_t size, size_t lda, size_t rhs_count, long double (* restrict a)[lda], long double (* restrict b)[rhs_count], int selection, int thread_count );
+#ifdef GAUSSIAN_HAVE_FLOAT128
+enum GaussianResult gaussian_solve_float128( size_t size, size_t lda, size_t rhs_count, __float128 (* restrict a)[lda], __float128 (* restrict b)[rhs_count], int selection, int thread_count );
+#endif
+
+//! Returns nonzero if the strategy 'selection' is available in the given precision.
+int gaussian_precision_has_strategy( enum GaussianPrecision precision, int selection );
+
+//! Returns the size of an element of the given precision, or zero if it is not supported.
+size_t gaussian_precision_size( enum GaussianPrecision precision );
+
+//! Solves a system whose elements have the given precision, chosen at run time.
+/*!
+ * The arrays a and b are laid out as for gaussian_solve, with elements of the given precision and
+ * lda elements from one row of a to the next.
+ * Every strategy is available in double precision. The other precisions have the serial,
+ * p_thread, and blocked strategies (see gaussian_precision_has_strategy); any other selection
+ * returns gaussian_error. Returns gaussian_error if the precision is not supported.
+ */
+enum GaussianResult gaussian_solve_precision( enum GaussianPrecision precision, size_t size, size_t lda, size_t rhs_count, void * restrict a, void * restrict b, int selection, int thread_count );
 
 #endif
@@ -0,0 +1,288 @@
+/*!
+ * \file   gaussian_batch.c
+ * \brief  A Gaussian Elimination solver for large batches of small systems.
+ *
+ * The batch is stored as a structure of arrays: element (i, j) of every system is stored in one
+ * run, so BATCH_LANES neighbouring systems can be carried through the elimination together, one
+ * per lane of a SIMD register. Each system still pivots on its own. Groups of lanes are divided
+ * among the threads of a ThreadPool.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "ThreadPool.h"
+#include "gaussian.h"
+
+// For profiling, it is best for all functions to be public.
+#define PRIVATE // static
+#define PUBLIC
+
+// Number of systems solved together. The loops over the lanes have this fixed trip count so the
+// compiler can turn them into vector instructions. Eight doubles fill an AVX-512 register.
+#ifndef BATCH_LANES
+#define BATCH_LANES 8
+#endif
+
+// Number of bytes of coefficients packed at a time. The packed systems should stay in the L2 cache
+// while they are solved.
+#ifndef BATCH_PACK_SIZE
+#define BATCH_PACK_SIZE ( 128 * 1024 )
+#endif
+
+// Batches with less work than this (counted in multiply-adds) are solved on the calling thread.
+// Starting a pool for them would cost more than it saves.
+#ifndef BATCH_THREAD_WORK
+#define BATCH_THREAD_WORK ( 1L << 22 )
+#endif
+
+//! Does y -= m * x in every lane.
+static inline void lane_update( floating_type * restrict y, const floating_type * restrict m, const floating_type * restrict x )
+{
+    for( size_t l = 0; l < BATCH_LANES; ++l ) {
+        y[l] -= m[l] * x[l];
+    }
+}
+
+//! Solves a packed group of BATCH_LANES systems. O(n^3) per system.
+/*!
+ * Element (i, j) of the system in lane l is a[( i * size + j ) * BATCH_LANES + l] and element i of
+ * its driving vector is b[i * BATCH_LANES + l]. The solutions replace the driving vectors. On
+ * return, degenerate[l] is nonzero if the system in lane l is degenerate. A degenerate lane is
+ * carried along with zero multipliers so it can't disturb the others, and its solution is zero.
+ */
+PRIVATE void batch_kernel( size_t size, floating_type *a, floating_type *b, int *degenerate )
+{
+    floating_type  pivot[BATCH_LANES];      // The largest |a[j][i]| found in each lane...
+    size_t         pivot_row[BATCH_LANES];  // ... and the row it is in.
+    floating_type  inverse[BATCH_LANES];    // 1 / a[i][i], or zero in a degenerate lane.
+    floating_type  m[BATCH_LANES];
+    floating_type *row_i, *row_k, *element;
+    floating_type  temp;
+    size_t         i, j, k, l, counter;
+
+    for( l = 0; l < BATCH_LANES; ++l ) {
+        degenerate[l] = 0;
+    }
+
+    for( i = 0; i < size; ++i ) {
+
+        // Find the row with the largest value of |a[j][i]|, j = i, ..., n - 1 in every lane.
+        element = &a[( i * size + i ) * BATCH_LANES];
+        for( l = 0; l < BATCH_LANES; ++l ) {
+            pivot[l] = fabs( element[l] );
+            pivot_row[l] = i;
+        }
+        for( j = i + 1; j < size; ++j ) {
+            element = &a[( j * size + i ) * BATCH_LANES];
+            for( l = 0; l < BATCH_LANES; ++l ) {
+                temp = fabs( element[l] );
+                pivot_row[l] = ( temp > pivot[l] ) ? j : pivot_row[l];
+                pivot[l] = ( temp > pivot[l] ) ? temp : pivot[l];
+            }
+        }
+
+        // Exchange row i and row k, if necessary, one lane at a time. The columns to the left of
+        // column i are not needed again.
+        for( l = 0; l < BATCH_LANES; ++l ) {
+            k = pivot_row[l];
+            if( k == i ) continue;
+            row_i = &a[( i * size ) * BATCH_LANES + l];
+            row_k = &a[( k * size ) * BATCH_LANES + l];
+            for( j = i; j < size; ++j ) {
+                temp = row_i[j * BATCH_LANES];
+                row_i[j * BATCH_LANES] = row_k[j * BATCH_LANES];
+                row_k[j * BATCH_LANES] = temp;
+            }
+
+            // Exchange corresponding elements of b.
+            temp = b[i * BATCH_LANES + l];
+            b[i * BATCH_LANES + l] = b[k * BATCH_LANES + l];
+            b[k * BATCH_LANES + l] = temp;
+        }
+
+        // Check for |a[i][i]| zero.
+        // TODO: The value 1.0E-6 is arbitrary. A more disciplined value should be used.
+        element = &a[( i * size + i ) * BATCH_LANES];
+        for( l = 0; l < BATCH_LANES; ++l ) {
+            degenerate[l] |= ( pivot[l] <= 1.0E-6 );
+            inverse[l] = degenerate[l] ? 0.0 : 1.0 / element[l];
+        }
+
+        // Subtract multiples of row i from subsequent rows.
+        for( j = i + 1; j < size; ++j ) {
+            element = &a[( j * size + i ) * BATCH_LANES];
+            for( l = 0; l < BATCH_LANES; ++l ) {
+                m[l] = element[l] * inverse[l];
+            }
+            for( k = i + 1; k < size; ++k ) {
+                lane_update( &a[( j * size + k ) * BATCH_LANES], m, &a[( i * size + k ) * BATCH_LANES] );
+            }
+            lane_update( &b[j * BATCH_LANES], m, &b[i * BATCH_LANES] );
+        }
+    }
+
+    // Back substitution in every lane. We can't count i down from size - 1 to zero (inclusive)
+    // because it is unsigned.
+    for( counter = 0; counter < size; ++counter ) {
+        i = ( size - 1 ) - counter;
+        for( j = i + 1; j < size; ++j ) {
+            lane_update( &b[i * BATCH_LANES], &a[( i * size + j ) * BATCH_LANES], &b[j * BATCH_LANES] );
+        }
+        element = &a[( i * size + i ) * BATCH_LANES];
+        for( l = 0; l < BATCH_LANES; ++l ) {
+            b[i * BATCH_LANES + l] = degenerate[l] ? 0.0 : b[i * BATCH_LANES + l] / element[l];
+        }
+    }
+}
+
+//! Solves 'lanes' neighbouring systems of a batch, a group of BATCH_LANES systems at a time.
+/*!
+ * In the batch the elements of one system are 'count' elements apart, so with a big batch every
+ * element of a group would be on a different page. The systems are therefore first packed into
+ * 'packed_a' and 'packed_b', one group after another, copying each run of the batch from start to
+ * end. A partial group at the end is padded out with identity systems so it can go through the
+ * same kernel. On return degenerate[s] is nonzero if system s is degenerate.
+ */
+PRIVATE void batch_block( size_t size, size_t count, const floating_type *a, floating_type *b, size_t lanes, floating_type *packed_a, floating_type *packed_b, int *degenerate )
+{
+    const size_t group_count = ( lanes + BATCH_LANES - 1 ) / BATCH_LANES;
+    const size_t group_a_size = size * size * BATCH_LANES;
+    const size_t group_b_size = size * BATCH_LANES;
+    size_t g, i, j, l, s;
+
+    for( i = 0; i < size; ++i ) {
+        for( j = 0; j < size; ++j ) {
+            for( g = 0, s = 0; g < group_count; ++g ) {
+                floating_type *target = &packed_a[g * group_a_size + ( i * size + j ) * BATCH_LANES];
+                for( l = 0; l < BATCH_LANES; ++l, ++s ) {
+                    target[l] = ( s < lanes ) ? a[( i * size + j ) * count + s] : ( i == j ) ? 1.0 : 0.0;
+                }
+            }
+        }
+        for( g = 0, s = 0; g < group_count; ++g ) {
+            floating_type *target = &packed_b[g * group_b_size + i * BATCH_LANES];
+            for( l = 0; l < BATCH_LANES; ++l, ++s ) {
+                target[l] = ( s < lanes ) ? b[i * count + s] : 0.0;
+            }
+        }
+    }
+
+    for( g = 0; g < group_count; ++g ) {
+        batch_kernel( size, &packed_a[g * group_a_size], &packed_b[g * group_b_size], &degenerate[g * BATCH_LANES] );
+    }
+
+    for( i = 0; i < size; ++i ) {
+        for( s = 0; s < lanes; ++s ) {
+            b[i * count + s] = packed_b[( s / BATCH_LANES ) * group_b_size + i * BATCH_LANES + s % BATCH_LANES];
+        }
+    }
+}
+
+
+// Structure to define the systems processed by a single thread.
+struct BatchWorkUnit {
+    floating_type *a;
+    floating_type *b;
+    enum GaussianResult *results;
+    size_t size;
+    size_t count;
+    size_t start;              // Index of the first system. A multiple of BATCH_LANES.
+    size_t stop;
+    size_t degenerate_count;
+};
+
+void * batch_work( void *arg )
+{
+    struct BatchWorkUnit *unit = (struct BatchWorkUnit *)arg;
+
+    const size_t size = unit->size;
+    const size_t count = unit->count;
+    size_t first, lanes, s;
+
+    // Pack as many whole groups at a time as fit in BATCH_PACK_SIZE bytes.
+    size_t block_size = BATCH_PACK_SIZE / ( size * size * BATCH_LANES * sizeof( floating_type ) );
+    block_size = ( block_size > 0 ) ? block_size * BATCH_LANES : BATCH_LANES;
+
+    floating_type *packed_a = (floating_type *)malloc( size * size * block_size * sizeof( floating_type ) );
+    floating_type *packed_b = (floating_type *)malloc( size * block_size * sizeof( floating_type ) );
+    int *degenerate = (int *)malloc( block_size * sizeof( int ) );
+
+    unit->degenerate_count = 0;
+    for( first = unit->start; first < unit->stop; first += block_size ) {
+        lanes = ( unit->stop - first < block_size ) ? unit->stop - first : block_size;
+        batch_block( size, count, &unit->a[first], &unit->b[first], lanes, packed_a, packed_b, degenerate );
+
+        for( s = 0; s < lanes; ++s ) {
+            if( degenerate[s] ) ++unit->degenerate_count;
+            if( unit->results != NULL ) {
+                unit->results[first + s] = degenerate[s] ? gaussian_degenerate : gaussian_success;
+            }
+        }
+    }
+
+    free( degenerate );
+    free( packed_b );
+    free( packed_a );
+    return NULL;
+}
+
+
+PUBLIC enum GaussianResult gaussian_solve_batch( size_t size, size_t count, floating_type (* restrict a)[size][count], floating_type (* restrict b)[count], enum GaussianResult * restrict results )
+{
+    // We can deal with 1x1 systems, but not empty systems.
+    if( size == 0 ) return gaussian_error;
+    if( count == 0 ) return gaussian_success;
+
+    size_t group_count = ( count + BATCH_LANES - 1 ) / BATCH_LANES;
+    size_t degenerate_count = 0;
+    int    unit_count = 1;
+    int    use_pool = ( group_count > 1 && size * size * size * count >= BATCH_THREAD_WORK );
+    ThreadPool pool;
+
+    if( use_pool ) {
+        ThreadPool_initialize( &pool, 0 );
+        unit_count = ThreadPool_count( &pool );
+        if( (size_t)unit_count > group_count ) unit_count = (int)group_count;
+    }
+
+    // Split the groups of lanes. Each unit gets whole groups so only the last can have a tail.
+    struct BatchWorkUnit *units =
+        (struct BatchWorkUnit *)malloc( unit_count * sizeof(struct BatchWorkUnit) );
+    size_t chunk_size = group_count / unit_count;
+    size_t remainder = group_count % unit_count;
+    size_t start = 0;
+    for( int h = 0; h < unit_count; ++h ) {
+        units[h].a = &a[0][0][0];
+        units[h].b = &b[0][0];
+        units[h].results = results;
+        units[h].size = size;
+        units[h].count = count;
+        units[h].start = start;
+        start += ( chunk_size + ( (size_t)h < remainder ) ) * BATCH_LANES;
+        units[h].stop = ( start < count ) ? start : count;
+    }
+
+    if( unit_count == 1 ) {
+        batch_work( &units[0] );
+        degenerate_count = units[0].degenerate_count;
+    }
+    else {
+        // There is one unit per thread in the pool, so none of these calls has to wait.
+        threadid_t *threads = (threadid_t *)malloc( unit_count * sizeof(threadid_t) );
+        for( int h = 0; h < unit_count; ++h ) {
+            threads[h] = ThreadPool_start( &pool, batch_work, &units[h] );
+        }
+        for( int h = 0; h < unit_count; ++h ) {
+            ThreadPool_result( &pool, threads[h] );
+            degenerate_count += units[h].degenerate_count;
+        }
+        free( threads );
+    }
+
+    if( use_pool ) {
+        ThreadPool_destroy( &pool );
+    }
+    free( units );
+    return ( degenerate_count == 0 ) ? gaussian_success : gaussian_degenerate;
+}
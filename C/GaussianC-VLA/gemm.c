@@ -0,0 +1,138 @@
+/*!
+ * \file   gemm.c
+ * \brief  A cache-blocked matrix-matrix product used for trailing updates.
+ *
+ * The loops are arranged as in BLIS. From the outside in: the columns of B are split into
+ * GEMM_NC panels (L3), the shared dimension into GEMM_KC slices (L2/L1) and the rows of A into
+ * GEMM_MC blocks (L2). Each slice of B and each block of A are packed before use so the
+ * micro-kernel reads both operands with unit stride.
+ */
+
+#include <stdlib.h>
+
+#include "gemm.h"
+
+// For profiling, it is best for all functions to be public.
+#define PRIVATE // static
+#define PUBLIC
+
+//! Copies a kc x nc slice of B into GEMM_NR wide column panels, padding the last with zeros.
+PRIVATE void pack_b( size_t kc, size_t nc, floating_type *const *b, size_t b_column, floating_type * restrict packed )
+{
+    size_t j, p, jr, width;
+
+    for( jr = 0; jr < nc; jr += GEMM_NR ) {
+        width = ( nc - jr < GEMM_NR ) ? nc - jr : GEMM_NR;
+        for( p = 0; p < kc; ++p ) {
+            const floating_type *row = &b[p][b_column + jr];
+            for( j = 0; j < width; ++j ) {
+                packed[j] = row[j];
+            }
+            for( ; j < GEMM_NR; ++j ) {
+                packed[j] = 0.0;
+            }
+            packed += GEMM_NR;
+        }
+    }
+}
+
+//! Copies an mc x kc block of A into GEMM_MR high row panels, padding the last with zeros.
+PRIVATE void pack_a( size_t mc, size_t kc, floating_type *const *a, size_t a_column, floating_type * restrict packed )
+{
+    size_t i, p, ir, height;
+
+    for( ir = 0; ir < mc; ir += GEMM_MR ) {
+        height = ( mc - ir < GEMM_MR ) ? mc - ir : GEMM_MR;
+        for( p = 0; p < kc; ++p ) {
+            for( i = 0; i < height; ++i ) {
+                packed[i] = a[ir + i][a_column + p];
+            }
+            for( ; i < GEMM_MR; ++i ) {
+                packed[i] = 0.0;
+            }
+            packed += GEMM_MR;
+        }
+    }
+}
+
+//! Computes an m x n (at most GEMM_MR x GEMM_NR) block of C -= A * B from packed panels.
+/*!
+ * The accumulators are a fixed GEMM_MR x GEMM_NR array so the compiler can keep them in vector
+ * registers for the whole kc loop. Only the part of the block inside C is written back.
+ */
+PRIVATE void micro_kernel( size_t kc, const floating_type * restrict a, const floating_type * restrict b, floating_type *const *c, size_t c_column, size_t m, size_t n )
+{
+    floating_type ab[GEMM_MR][GEMM_NR] = { { 0.0 } };
+    size_t i, j, p;
+
+    for( p = 0; p < kc; ++p ) {
+        for( i = 0; i < GEMM_MR; ++i ) {
+            for( j = 0; j < GEMM_NR; ++j ) {
+                ab[i][j] += a[i] * b[j];
+            }
+        }
+        a += GEMM_MR;
+        b += GEMM_NR;
+    }
+
+    for( i = 0; i < m; ++i ) {
+        floating_type *row = &c[i][c_column];
+        for( j = 0; j < n; ++j ) {
+            row[j] -= ab[i][j];
+        }
+    }
+}
+
+//! Multiplies a packed block of A by a packed slice of B, one register block at a time.
+PRIVATE void macro_kernel( size_t mc, size_t nc, size_t kc, const floating_type *packed_a, const floating_type *packed_b, floating_type *const *c, size_t c_column )
+{
+    size_t ir, jr, height, width;
+
+    for( jr = 0; jr < nc; jr += GEMM_NR ) {
+        width = ( nc - jr < GEMM_NR ) ? nc - jr : GEMM_NR;
+        for( ir = 0; ir < mc; ir += GEMM_MR ) {
+            height = ( mc - ir < GEMM_MR ) ? mc - ir : GEMM_MR;
+            micro_kernel(
+                kc, &packed_a[ir * kc], &packed_b[jr * kc], &c[ir], c_column + jr, height, width );
+        }
+    }
+}
+
+
+PUBLIC void gemm_update(
+    size_t m, size_t n, size_t k,
+    floating_type *const *a, size_t a_column,
+    floating_type *const *b, size_t b_column,
+    floating_type *const *c, size_t c_column )
+{
+    size_t ic, jc, pc, mc, nc, kc;
+
+    if( m == 0 || n == 0 || k == 0 ) return;
+
+    // Size the buffers for this product rather than for the largest possible blocks. Panels are
+    // rounded up to whole register blocks because packing pads them with zeros.
+    size_t max_mc = ( m < GEMM_MC ) ? m : GEMM_MC;
+    size_t max_nc = ( n < GEMM_NC ) ? n : GEMM_NC;
+    size_t max_kc = ( k < GEMM_KC ) ? k : GEMM_KC;
+    max_mc = ( max_mc + GEMM_MR - 1 ) / GEMM_MR * GEMM_MR;
+    max_nc = ( max_nc + GEMM_NR - 1 ) / GEMM_NR * GEMM_NR;
+
+    floating_type *packed_a = (floating_type *)malloc( max_mc * max_kc * sizeof( floating_type ) );
+    floating_type *packed_b = (floating_type *)malloc( max_kc * max_nc * sizeof( floating_type ) );
+
+    for( jc = 0; jc < n; jc += GEMM_NC ) {
+        nc = ( n - jc < GEMM_NC ) ? n - jc : GEMM_NC;
+        for( pc = 0; pc < k; pc += GEMM_KC ) {
+            kc = ( k - pc < GEMM_KC ) ? k - pc : GEMM_KC;
+            pack_b( kc, nc, &b[pc], b_column + jc, packed_b );
+            for( ic = 0; ic < m; ic += GEMM_MC ) {
+                mc = ( m - ic < GEMM_MC ) ? m - ic : GEMM_MC;
+                pack_a( mc, kc, &a[ic], a_column + pc, packed_a );
+                macro_kernel( mc, nc, kc, packed_a, packed_b, &c[ic], c_column + jc );
+            }
+        }
+    }
+
+    free( packed_b );
+    free( packed_a );
+}
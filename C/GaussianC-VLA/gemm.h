@@ -0,0 +1,53 @@
+/*!
+ * \file   gemm.h
+ * \brief  Interface to a cache-blocked matrix-matrix product used for trailing updates.
+ *
+ * The implementation follows the structure popularized by BLIS: the operands are copied ("packed")
+ * into contiguous buffers sized for the L1, L2, and L3 caches and the product is computed by a
+ * small register-blocked micro-kernel that only ever sees packed data.
+ */
+
+#ifndef GEMM_H
+#define GEMM_H
+
+#include <stddef.h>
+
+#include "gaussian.h"
+
+// Register block of the micro-kernel. Packed A panels are GEMM_MR rows high and packed B panels
+// are GEMM_NR columns wide.
+#define GEMM_MR 4
+#define GEMM_NR 8
+
+// Cache blocks. A GEMM_KC x GEMM_NR sliver of B stays in L1, a GEMM_MC x GEMM_KC block of A stays
+// in L2, and a GEMM_KC x GEMM_NC panel of B stays in L3. Compile with -D to tune for a host.
+#ifndef GEMM_MC
+#define GEMM_MC 96
+#endif
+#ifndef GEMM_KC
+#define GEMM_KC 256
+#endif
+#ifndef GEMM_NC
+#define GEMM_NC 4096
+#endif
+
+//! Computes C -= A * B.
+/*!
+ * Each matrix is described by a table of pointers to its rows and the column at which it starts
+ * in those rows, so the rows need not be evenly spaced or in memory order. This lets the solver
+ * pass blocks of a matrix whose rows have been reordered by pivoting. The matrices may be blocks
+ * of the same larger matrix provided C does not overlap A or B. The function allocates its own
+ * packing buffers so several threads may call it at once on disjoint blocks of C, for example on
+ * their own bands of rows of a trailing matrix.
+ *
+ * \param m The number of rows in A and C.
+ * \param n The number of columns in B and C.
+ * \param k The number of columns in A and rows in B.
+ */
+void gemm_update(
+    size_t m, size_t n, size_t k,
+    floating_type *const *a, size_t a_column,
+    floating_type *const *b, size_t b_column,
+    floating_type *const *c, size_t c_column );
+
+#endif
@@ -0,0 +1,196 @@
+/*!
+ * \file    SystemGenerator.c
+ * \brief   Implementation of a generator of reproducible systems of simultaneous equations.
+ *
+ * Element (i, j) is the SplitMix64 finalizer applied to row i's seed plus (j + 1) times the
+ * golden gamma, which is what SplitMix64 would produce as the (j + 1)th value of row i's stream.
+ * Any element can thus be made without making the ones before it.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "SystemGenerator.h"
+
+#define GOLDEN_GAMMA 0x9E3779B97F4A7C15u
+
+static const char *class_names[] = { "dense", "dominant", "spd", "banded", "near-singular", "sparse" };
+
+// Structure to define the rows generated by a single thread.
+struct GeneratorWorkUnit {
+    const SystemGenerator *generator;
+    size_t  first;
+    size_t  last;
+    double *a;
+    double *b;
+};
+
+//! The SplitMix64 finalizer. Consecutive inputs give statistically independent outputs.
+static inline uint64_t mix( uint64_t z )
+{
+    z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9u;
+    z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBu;
+    return z ^ ( z >> 31 );
+}
+
+//! Returns the top 53 bits of 'bits' as a double uniform on [-1, 1).
+static inline double to_uniform( uint64_t bits )
+{
+    return (double)( bits >> 11 ) * 0x1p-52 - 1.0;
+}
+
+//! Returns the random value for position (i, j).
+static inline double random_element( const SystemGenerator *self, size_t i, size_t j )
+{
+    return to_uniform( mix( self->row_seeds[i] + ( j + 1 ) * GOLDEN_GAMMA ) );
+}
+
+
+int SystemGenerator_parse_class( const char *name, enum SystemClass *system_class )
+{
+    for( size_t c = 0; c < sizeof( class_names ) / sizeof( class_names[0] ); ++c ) {
+        if( strcmp( name, class_names[c] ) == 0 ) {
+            *system_class = (enum SystemClass)c;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+int SystemGenerator_initialize( SystemGenerator *self, enum SystemClass system_class, size_t size, size_t rhs_count, uint64_t seed )
+{
+    self->system_class = system_class;
+    self->size = size;
+    self->rhs_count = rhs_count;
+    self->bandwidth = 16;
+    self->density = 0.01;
+    self->epsilon = 1.0E-5;
+
+    // The streams of the rows and of the known solution.
+    self->row_seeds = (uint64_t *)malloc( size * sizeof( uint64_t ) );
+    self->solution = (double *)malloc( size * rhs_count * sizeof( double ) );
+    if( self->row_seeds == NULL || self->solution == NULL ) {
+        SystemGenerator_destroy( self );
+        self->row_seeds = NULL;
+        self->solution = NULL;
+        return 0;
+    }
+    uint64_t base = mix( seed ^ mix( (uint64_t)system_class + 1 ) );
+    for( size_t i = 0; i < size; ++i ) {
+        self->row_seeds[i] = mix( base + ( i + 1 ) * GOLDEN_GAMMA );
+    }
+    uint64_t solution_base = mix( base ^ 0x736F6C7574696F6Eu );
+    for( size_t i = 0; i < size * rhs_count; ++i ) {
+        self->solution[i] = to_uniform( mix( solution_base + ( i + 1 ) * GOLDEN_GAMMA ) );
+    }
+    return 1;
+}
+
+
+void SystemGenerator_destroy( SystemGenerator *self )
+{
+    free( self->solution );
+    free( self->row_seeds );
+}
+
+
+void SystemGenerator_row( const SystemGenerator *self, size_t i, double *row )
+{
+    const size_t size = self->size;
+    double off_diagonal = 0.0;
+    size_t j;
+
+    switch( self->system_class ) {
+    case class_dense:
+        for( j = 0; j < size; ++j ) row[j] = random_element( self, i, j );
+        break;
+
+    case class_dominant:
+    case class_spd:
+        for( j = 0; j < size; ++j ) {
+            // An SPD system takes element (i, j) from the stream of the lower index, so it is
+            // symmetric. Symmetric and strictly dominant with a positive diagonal is positive
+            // definite.
+            row[j] = ( self->system_class == class_spd && j < i ) ? random_element( self, j, i )
+                                                                  : random_element( self, i, j );
+            if( j != i ) off_diagonal += ( row[j] < 0 ) ? -row[j] : row[j];
+        }
+        row[i] = off_diagonal + 1.0;
+        break;
+
+    case class_banded:
+        for( j = 0; j < size; ++j ) {
+            size_t distance = ( i > j ) ? i - j : j - i;
+            row[j] = ( distance <= self->bandwidth ) ? random_element( self, i, j ) : 0.0;
+            if( j != i ) off_diagonal += ( row[j] < 0 ) ? -row[j] : row[j];
+        }
+        row[i] = off_diagonal + 1.0;
+        break;
+
+    case class_near_singular:
+        for( j = 0; j < size; ++j ) {
+            row[j] = random_element( self, i, j );
+            if( i == size - 1 && size > 2 ) {
+                row[j] = 0.5 * ( random_element( self, 0, j ) + random_element( self, 1, j ) ) +
+                         self->epsilon * row[j];
+            }
+        }
+        break;
+
+    case class_sparse:
+        for( j = 0; j < size; ++j ) {
+            uint64_t bits = mix( self->row_seeds[i] + ( j + 1 ) * GOLDEN_GAMMA );
+            if( j == i ) {
+                row[j] = 1.5 + 0.5 * to_uniform( bits );
+            }
+            else {
+                row[j] = ( (double)( bits >> 11 ) * 0x1p-53 < self->density ) ? to_uniform( mix( bits ) ) : 0.0;
+            }
+        }
+        break;
+    }
+}
+
+
+void SystemGenerator_driving( const SystemGenerator *self, const double *row, double *b_row )
+{
+    for( size_t c = 0; c < self->rhs_count; ++c ) {
+        double sum = 0.0;
+        for( size_t j = 0; j < self->size; ++j ) {
+            sum += row[j] * self->solution[j * self->rhs_count + c];
+        }
+        b_row[c] = sum;
+    }
+}
+
+
+//! Generates rows [first, last) of the system.
+static void *fill_work( void *arg )
+{
+    struct GeneratorWorkUnit *unit = (struct GeneratorWorkUnit *)arg;
+    const SystemGenerator *generator = unit->generator;
+
+    for( size_t i = unit->first; i < unit->last; ++i ) {
+        double *row = &unit->a[i * generator->size];
+        SystemGenerator_row( generator, i, row );
+        SystemGenerator_driving( generator, row, &unit->b[i * generator->rhs_count] );
+    }
+    return NULL;
+}
+
+
+void SystemGenerator_fill( const SystemGenerator *self, WorkerTeam *team, double *a, double *b )
+{
+    int thread_count = WorkerTeam_count( team );
+    struct GeneratorWorkUnit units[thread_count];
+
+    for( int h = 0; h < thread_count; ++h ) {
+        units[h].generator = self;
+        units[h].first = self->size * h / thread_count;
+        units[h].last = self->size * ( h + 1 ) / thread_count;
+        units[h].a = a;
+        units[h].b = b;
+    }
+    WorkerTeam_run( team, fill_work, units, sizeof( struct GeneratorWorkUnit ) );
+}
@@ -0,0 +1,82 @@
+/*!
+ * \file    SystemGenerator.h
+ * \brief   Interface to a generator of reproducible systems of simultaneous equations.
+ *
+ * Every element is a function of the seed and its position alone (a counter-based generator), so
+ * the same seed gives the same system however the work is divided among threads. The solution is
+ * chosen first and the driving vectors are computed from it, so the solution of every generated
+ * system is known.
+ */
+
+#ifndef SYSTEMGENERATOR_H
+#define SYSTEMGENERATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../WorkerTeam.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//! The structure of a generated system.
+enum SystemClass {
+    class_dense,            // Uniform on [-1, 1).
+    class_dominant,         // Dense and strictly diagonally dominant.
+    class_spd,              // Symmetric and strictly diagonally dominant with a positive diagonal.
+    class_banded,           // Zero outside the band, diagonally dominant within it.
+    class_near_singular,    // Dense, with the last row epsilon away from a combination of two others.
+    class_sparse            // Mostly zero, with a nonzero diagonal.
+};
+
+//! Converts the name of a class (dense, dominant, spd, banded, near-singular, sparse).
+/*!
+ * Returns nonzero if the name is known.
+ */
+int SystemGenerator_parse_class( const char *name, enum SystemClass *system_class );
+
+// SystemGenerator class
+// =====================
+
+//! Generates the rows of one system.
+typedef struct {
+    enum SystemClass system_class;
+    size_t    size;
+    size_t    rhs_count;
+    size_t    bandwidth;    // Half-width of the band of a banded system. Default 16.
+    double    density;      // Fraction of the off-diagonal elements of a sparse system that aren't zero. Default 0.01.
+    double    epsilon;      // How far a near-singular system is from singular. Default 1e-5.
+    uint64_t *row_seeds;    // One stream per row.
+    double   *solution;     // The known solution, size x rhs_count in row-major order.
+} SystemGenerator;
+
+//! Initializes the generator pointed at by 'self' for the system given by the class and seed.
+/*!
+ * The parameters of the classes get their defaults and may be changed before any rows are made.
+ * Returns zero if the memory for the row streams and the known solution can't be had; there is
+ * then nothing to destroy.
+ */
+int SystemGenerator_initialize( SystemGenerator *self, enum SystemClass system_class, size_t size, size_t rhs_count, uint64_t seed );
+
+//! Releases the resources of the generator pointed at by 'self'.
+void SystemGenerator_destroy( SystemGenerator *self );
+
+//! Generates row i of the matrix of coefficients into 'row' (size elements).
+void SystemGenerator_row( const SystemGenerator *self, size_t i, double *row );
+
+//! Computes the driving vector elements of a row (rhs_count elements) from the row.
+void SystemGenerator_driving( const SystemGenerator *self, const double *row, double *b_row );
+
+//! Generates the whole system into a (size x size) and b (size x rhs_count), both row-major.
+/*!
+ * The rows are divided among the members of the team, so each page is first touched by the
+ * thread that fills it.
+ */
+void SystemGenerator_fill( const SystemGenerator *self, WorkerTeam *team, double *a, double *b );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
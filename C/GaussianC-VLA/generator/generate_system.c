@@ -0,0 +1,237 @@
+/*!
+ *  \file   generate_system.c
+ *  \brief  Generate reproducible systems of simultaneous equations for testing and benchmarking.
+ *
+ * The same seed gives the same system whatever the number of threads (see SystemGenerator.h).
+ * The solution of every generated system is known and can be written out for checking the
+ * solver.
+ *
+ * Usage: generate_system SIZE [options]
+ *
+ *   --class=NAME     dense (the default), dominant, spd, banded, near-singular, or sparse.
+ *   --seed=N         The seed (default 1).
+ *   --rhs=M          The number of driving vectors (default 1).
+ *   --bandwidth=K    The half-width of the band of a banded system (default 16).
+ *   --density=D      The fraction of the off-diagonal elements of a sparse system that aren't
+ *                    zero (default 0.01).
+ *   --epsilon=E      How far a near-singular system is from singular (default 1e-5).
+ *   --threads=T      The number of threads (default: one per processor).
+ *   --output=PATH    Where to write the system (default: standard output).
+ *   --binary         Write a .gsys file rather than text. Needs --output.
+ *   --solution=PATH  Also write the known solution, as text or (with --binary) raw binary.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__GLIBC__) || defined(__CYGWIN__)
+#include <sys/sysinfo.h>  // For get_nprocs( ).
+#endif
+
+#include "../WorkerTeam.h"
+#include "../gaussian.h"
+#include "../gsys.h"
+#include "../solution_output.h"
+#include "SystemGenerator.h"
+
+// Text is produced in rounds of about this many bytes, so large systems needn't fit in memory.
+#define GENERATOR_ROUND_BYTES ( 64L << 20 )
+
+// The longest number written is 24 characters and a space.
+#define GENERATOR_NUMBER_WIDTH 25
+
+// Structure to define the rows formatted by a single thread in one round.
+struct TextWorkUnit {
+    const SystemGenerator *generator;
+    size_t  first;
+    size_t  last;
+    double *row;            // Scratch space for one row.
+    char   *text;           // The text of rows [first, last).
+    size_t  text_used;
+};
+
+//! Generates rows [first, last) as text into the unit's buffer.
+static void *text_work( void *arg )
+{
+    struct TextWorkUnit *unit = (struct TextWorkUnit *)arg;
+    const SystemGenerator *generator = unit->generator;
+    double b_row[generator->rhs_count];
+    char  *p = unit->text;
+
+    for( size_t i = unit->first; i < unit->last; ++i ) {
+        SystemGenerator_row( generator, i, unit->row );
+        SystemGenerator_driving( generator, unit->row, b_row );
+        for( size_t j = 0; j < generator->size; ++j ) {
+            p += solution_format_double( unit->row[j], p );
+            *p++ = ' ';
+        }
+        for( size_t c = 0; c < generator->rhs_count; ++c ) {
+            p += solution_format_double( b_row[c], p );
+            *p++ = ' ';
+        }
+        p[-1] = '\n';
+    }
+    unit->text_used = (size_t)( p - unit->text );
+    return NULL;
+}
+
+
+//! Returns nonzero if 'argument' is "--name=..." and points *value at the text after the '='.
+static int option( const char *argument, const char *name, const char **value )
+{
+    size_t length = strlen( name );
+    if( strncmp( argument, name, length ) != 0 || argument[length] != '=' ) return 0;
+    *value = argument + length + 1;
+    return 1;
+}
+
+
+int main( int argc, char *argv[] )
+{
+    enum SystemClass system_class = class_dense;
+    size_t      size = 0;
+    size_t      rhs_count = 1;
+    size_t      bandwidth = 16;
+    double      density = 0.01;
+    double      epsilon = 1.0E-5;
+    uint64_t    seed = 1;
+    int         binary = 0;
+    const char *output_path = NULL;
+    const char *solution_path = NULL;
+    const char *value;
+    #if defined(__GLIBC__) || defined(__CYGWIN__)
+    int thread_count = get_nprocs( );
+    #else
+    int thread_count = pthread_num_processors_np( );
+    #endif
+
+    for( int i = 1; i < argc; ++i ) {
+        if( option( argv[i], "--class", &value ) ) {
+            if( !SystemGenerator_parse_class( value, &system_class ) ) {
+                fprintf( stderr, "Error: Unknown class '%s'.\n", value );
+                return EXIT_FAILURE;
+            }
+        }
+        else if( option( argv[i], "--seed", &value ) )      seed = strtoull( value, NULL, 10 );
+        else if( option( argv[i], "--rhs", &value ) )       rhs_count = strtoul( value, NULL, 10 );
+        else if( option( argv[i], "--bandwidth", &value ) ) bandwidth = strtoul( value, NULL, 10 );
+        else if( option( argv[i], "--density", &value ) )   density = strtod( value, NULL );
+        else if( option( argv[i], "--epsilon", &value ) )   epsilon = strtod( value, NULL );
+        else if( option( argv[i], "--threads", &value ) )   thread_count = atoi( value );
+        else if( option( argv[i], "--output", &value ) )    output_path = value;
+        else if( option( argv[i], "--solution", &value ) )  solution_path = value;
+        else if( strcmp( argv[i], "--binary" ) == 0 )       binary = 1;
+        else if( size == 0 )                                size = strtoul( argv[i], NULL, 10 );
+        else {
+            fprintf( stderr, "Error: Unexpected argument '%s'.\n", argv[i] );
+            return EXIT_FAILURE;
+        }
+    }
+    if( size == 0 || rhs_count == 0 || thread_count < 1 ) {
+        fprintf( stderr, "Usage: generate_system SIZE [--class=NAME] [--seed=N] [--rhs=M] [--bandwidth=K]\n"
+                         "       [--density=D] [--epsilon=E] [--threads=T] [--output=PATH] [--binary]\n"
+                         "       [--solution=PATH]\n" );
+        return EXIT_FAILURE;
+    }
+    if( binary && output_path == NULL ) {
+        fprintf( stderr, "Error: Binary output needs a file named with --output=PATH.\n" );
+        return EXIT_FAILURE;
+    }
+
+    SystemGenerator generator;
+    if( !SystemGenerator_initialize( &generator, system_class, size, rhs_count, seed ) ) {
+        fprintf( stderr, "Error: Not enough memory for a system of size %zu.\n", size );
+        return EXIT_FAILURE;
+    }
+    generator.bandwidth = bandwidth;
+    generator.density = density;
+    generator.epsilon = epsilon;
+
+    WorkerTeam team;
+    WorkerTeam_initialize( &team, thread_count );
+    int failed = 0;
+
+    if( binary ) {
+        // Each thread fills its own rows of the mapped file.
+        GsysFile file;
+        enum GsysResult result = gsys_create( output_path, precision_double, size, rhs_count, &file );
+        if( result == gsys_success ) {
+            SystemGenerator_fill( &generator, &team, (double *)file.a, (double *)file.b );
+            result = gsys_finish( &file, 1 );
+        }
+        if( result != gsys_success ) {
+            fprintf( stderr, "Error: Can not write %s: %s.\n", output_path, gsys_result_text( result ) );
+            failed = 1;
+        }
+    }
+    else {
+        // Each round the threads format a block of rows into their buffers, which are then
+        // written in order.
+        FILE *output = ( output_path == NULL ) ? stdout : fopen( output_path, "w" );
+        if( output == NULL ) {
+            fprintf( stderr, "Error: Can not open %s.\n", output_path );
+            failed = 1;
+        }
+        else {
+            size_t row_bytes = ( size + rhs_count ) * GENERATOR_NUMBER_WIDTH;
+            size_t rows_per_unit = GENERATOR_ROUND_BYTES / thread_count / row_bytes + 1;
+            struct TextWorkUnit *units =
+                (struct TextWorkUnit *)calloc( thread_count, sizeof( struct TextWorkUnit ) );
+            int have_memory = ( units != NULL );
+            for( int h = 0; have_memory && h < thread_count; ++h ) {
+                units[h].generator = &generator;
+                units[h].row = (double *)malloc( size * sizeof( double ) );
+                units[h].text = (char *)malloc( rows_per_unit * row_bytes );
+                if( units[h].row == NULL || units[h].text == NULL ) have_memory = 0;
+            }
+
+            if( !have_memory ) {
+                fprintf( stderr, "Error: Not enough memory for the output buffers.\n" );
+                failed = 1;
+            }
+            else {
+                if( rhs_count == 1 ) fprintf( output, "%zu\n", size );
+                else                 fprintf( output, "%zu %zu\n", size, rhs_count );
+                for( size_t first = 0; first < size && !failed; first += rows_per_unit * thread_count ) {
+                    for( int h = 0; h < thread_count; ++h ) {
+                        size_t start = first + rows_per_unit * h;
+                        units[h].first = ( start < size ) ? start : size;
+                        units[h].last = ( start + rows_per_unit < size ) ? start + rows_per_unit : size;
+                    }
+                    WorkerTeam_run( &team, text_work, units, sizeof( struct TextWorkUnit ) );
+                    for( int h = 0; h < thread_count; ++h ) {
+                        if( fwrite( units[h].text, 1, units[h].text_used, output ) != units[h].text_used ) failed = 1;
+                    }
+                }
+                if( failed ) fprintf( stderr, "Error: Can not write the system.\n" );
+            }
+            if( output != stdout && fclose( output ) != 0 && !failed ) {
+                fprintf( stderr, "Error: Can not write the system.\n" );
+                failed = 1;
+            }
+
+            if( units != NULL ) {
+                for( int h = 0; h < thread_count; ++h ) {
+                    free( units[h].row );
+                    free( units[h].text );
+                }
+            }
+            free( units );
+        }
+    }
+    WorkerTeam_destroy( &team );
+
+    // The known solution, in the same form solve_system writes.
+    if( !failed && solution_path != NULL ) {
+        FILE *solution_file = fopen( solution_path, binary ? "wb" : "w" );
+        if( solution_file == NULL ||
+            !solution_write( solution_file, binary ? solution_binary : solution_text, precision_double, size, rhs_count, generator.solution ) ) {
+            fprintf( stderr, "Error: Can not write the solution to %s.\n", solution_path );
+            failed = 1;
+        }
+        if( solution_file != NULL ) fclose( solution_file );
+    }
+
+    SystemGenerator_destroy( &generator );
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,257 @@
+/*!
+ * \file   gsys.c
+ * \brief  Reading and writing the binary system file format (.gsys).
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "gsys.h"
+
+// For profiling, it is best for all functions to be public.
+#define PRIVATE // static
+#define PUBLIC
+
+_Static_assert( sizeof( struct GsysHeader ) == 64, "The .gsys header must be 64 bytes" );
+
+static const char gsys_magic[4] = { 'G', 'S', 'Y', 'S' };
+
+
+PUBLIC uint64_t gsys_checksum( const void *data, size_t count )
+{
+    // FNV-1a, taken a word at a time rather than a byte at a time. Four independent lanes keep
+    // the multiplier busy; they are combined at the end.
+    const uint64_t prime = 0x100000001B3u;
+    uint64_t lane[4] = { 0xCBF29CE484222325u, 0x84222325CBF29CE4u, 0xCBF29CE484222325u ^ 1, 0x84222325CBF29CE4u ^ 1 };
+    const unsigned char *bytes = (const unsigned char *)data;
+    size_t words = count / 8;
+    size_t i;
+    uint64_t word;
+
+    for( i = 0; i + 4 <= words; i += 4 ) {
+        for( size_t l = 0; l < 4; ++l ) {
+            memcpy( &word, &bytes[( i + l ) * 8], 8 );
+            lane[l] = ( lane[l] ^ word ) * prime;
+        }
+    }
+    for( ; i < words; ++i ) {
+        memcpy( &word, &bytes[i * 8], 8 );
+        lane[0] = ( lane[0] ^ word ) * prime;
+    }
+    if( count % 8 != 0 ) {
+        word = 0;
+        memcpy( &word, &bytes[words * 8], count % 8 );
+        lane[0] = ( lane[0] ^ word ) * prime;
+    }
+    return ( ( lane[0] * prime ^ lane[1] ) * prime ^ lane[2] ) * prime ^ lane[3];
+}
+
+
+//! Returns the checksum stored in the header for a system with the given data.
+PRIVATE uint64_t system_checksum( const void *a, size_t a_size, const void *b, size_t b_size )
+{
+    return gsys_checksum( a, a_size ) * 0x100000001B3u ^ gsys_checksum( b, b_size );
+}
+
+
+//! Finds the bytes taken by the matrix and the driving vectors. Returns zero if they overflow.
+/*!
+ * The sizes come from file headers, so every product is checked. The total leaves room for the
+ * header as well.
+ */
+PRIVATE int system_data_size( size_t size, size_t rhs_count, size_t element_size, size_t *a_size, size_t *b_size )
+{
+    if( size == 0 || rhs_count == 0 || element_size == 0 ||
+        size > SIZE_MAX / element_size / size ||
+        rhs_count > SIZE_MAX / element_size / size ) {
+        return 0;
+    }
+    *a_size = size * size * element_size;
+    *b_size = size * rhs_count * element_size;
+    return *b_size <= SIZE_MAX - sizeof( struct GsysHeader ) - *a_size;
+}
+
+
+PUBLIC int gsys_is_gsys( const char *path )
+{
+    char  magic[4];
+    FILE *file = fopen( path, "rb" );
+
+    if( file == NULL ) return 0;
+    int result = fread( magic, 1, sizeof( magic ), file ) == sizeof( magic ) &&
+                 memcmp( magic, gsys_magic, sizeof( magic ) ) == 0;
+    fclose( file );
+    return result;
+}
+
+
+PUBLIC enum GsysResult gsys_map( const char *path, int verify, GsysFile *file )
+{
+    struct stat status;
+    struct GsysHeader header;
+    size_t a_size, b_size;
+    int descriptor;
+
+    memset( file, 0, sizeof( *file ) );
+    if( ( descriptor = open( path, O_RDONLY ) ) < 0 ) return gsys_io_error;
+    if( fstat( descriptor, &status ) != 0 ) {
+        close( descriptor );
+        return gsys_io_error;
+    }
+    if( (size_t)status.st_size < sizeof( header ) ||
+        pread( descriptor, &header, sizeof( header ), 0 ) != (ssize_t)sizeof( header ) ) {
+        close( descriptor );
+        return gsys_format_error;
+    }
+
+    // Check everything in the header before trusting the sizes in it.
+    size_t element_size = gaussian_precision_size( (enum GaussianPrecision)header.element_type );
+    if( memcmp( header.magic, gsys_magic, sizeof( gsys_magic ) ) != 0 ||
+        header.version != GSYS_VERSION ||
+        header.byte_order != GSYS_BYTE_ORDER ||
+        header.layout != GSYS_LAYOUT_SEPARATE ||
+        element_size == 0 || header.element_size != element_size ||
+        header.size > SIZE_MAX || header.rhs_count > SIZE_MAX ||
+        !system_data_size( header.size, header.rhs_count, element_size, &a_size, &b_size ) ) {
+        close( descriptor );
+        return gsys_format_error;
+    }
+    size_t data_size = a_size + b_size;
+    if( (size_t)status.st_size - sizeof( header ) < data_size ) {
+        close( descriptor );
+        return gsys_format_error;
+    }
+
+    // The mapping stays valid after the descriptor is closed.
+    void *mapping = mmap( NULL, sizeof( header ) + data_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, descriptor, 0 );
+    close( descriptor );
+    if( mapping == MAP_FAILED ) return gsys_io_error;
+
+    unsigned char *data = (unsigned char *)mapping + sizeof( header );
+    if( verify && ( header.flags & GSYS_CHECKSUM ) &&
+        system_checksum( data, a_size, data + a_size, b_size ) != header.checksum ) {
+        munmap( mapping, sizeof( header ) + data_size );
+        return gsys_checksum_error;
+    }
+
+    file->mapping = mapping;
+    file->mapping_size = sizeof( header ) + data_size;
+    file->precision = (enum GaussianPrecision)header.element_type;
+    file->size = header.size;
+    file->rhs_count = header.rhs_count;
+    file->a = data;
+    file->b = data + a_size;
+    return gsys_success;
+}
+
+
+PUBLIC void gsys_unmap( GsysFile *file )
+{
+    if( file->mapping != NULL ) {
+        munmap( file->mapping, file->mapping_size );
+    }
+    memset( file, 0, sizeof( *file ) );
+}
+
+
+//! Fills in a header for a system without a checksum.
+PRIVATE void fill_header( struct GsysHeader *header, enum GaussianPrecision precision, size_t size, size_t rhs_count )
+{
+    memset( header, 0, sizeof( *header ) );
+    memcpy( header->magic, gsys_magic, sizeof( gsys_magic ) );
+    header->version = GSYS_VERSION;
+    header->byte_order = GSYS_BYTE_ORDER;
+    header->element_type = (uint32_t)precision;
+    header->element_size = (uint32_t)gaussian_precision_size( precision );
+    header->layout = GSYS_LAYOUT_SEPARATE;
+    header->size = size;
+    header->rhs_count = rhs_count;
+}
+
+
+PUBLIC enum GsysResult gsys_write( const char *path, enum GaussianPrecision precision, size_t size, size_t rhs_count, const void *a, const void *b, int checksum )
+{
+    struct GsysHeader header;
+    size_t element_size = gaussian_precision_size( precision );
+    size_t a_size, b_size;
+    FILE  *file;
+
+    if( !system_data_size( size, rhs_count, element_size, &a_size, &b_size ) ) return gsys_format_error;
+
+    fill_header( &header, precision, size, rhs_count );
+    if( checksum ) {
+        header.checksum = system_checksum( a, a_size, b, b_size );
+        header.flags |= GSYS_CHECKSUM;
+    }
+
+    if( ( file = fopen( path, "wb" ) ) == NULL ) return gsys_io_error;
+    int ok = fwrite( &header, sizeof( header ), 1, file ) == 1 &&
+             fwrite( a, 1, a_size, file ) == a_size &&
+             fwrite( b, 1, b_size, file ) == b_size;
+    ok = ( fclose( file ) == 0 ) && ok;
+    return ok ? gsys_success : gsys_io_error;
+}
+
+
+PUBLIC enum GsysResult gsys_create( const char *path, enum GaussianPrecision precision, size_t size, size_t rhs_count, GsysFile *file )
+{
+    size_t element_size = gaussian_precision_size( precision );
+    int    descriptor;
+
+    memset( file, 0, sizeof( *file ) );
+    size_t a_size, b_size;
+    if( !system_data_size( size, rhs_count, element_size, &a_size, &b_size ) ) return gsys_format_error;
+
+    size_t mapping_size = sizeof( struct GsysHeader ) + a_size + b_size;
+    if( ( descriptor = open( path, O_RDWR | O_CREAT | O_TRUNC, 0644 ) ) < 0 ) return gsys_io_error;
+    if( ftruncate( descriptor, (off_t)mapping_size ) != 0 ) {
+        close( descriptor );
+        return gsys_io_error;
+    }
+    void *mapping = mmap( NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0 );
+    close( descriptor );
+    if( mapping == MAP_FAILED ) return gsys_io_error;
+
+    fill_header( (struct GsysHeader *)mapping, precision, size, rhs_count );
+    unsigned char *data = (unsigned char *)mapping + sizeof( struct GsysHeader );
+    file->mapping = mapping;
+    file->mapping_size = mapping_size;
+    file->precision = precision;
+    file->size = size;
+    file->rhs_count = rhs_count;
+    file->a = data;
+    file->b = data + a_size;
+    return gsys_success;
+}
+
+
+PUBLIC enum GsysResult gsys_finish( GsysFile *file, int checksum )
+{
+    struct GsysHeader *header = (struct GsysHeader *)file->mapping;
+    size_t a_size = (unsigned char *)file->b - (unsigned char *)file->a;
+    size_t b_size = file->mapping_size - sizeof( struct GsysHeader ) - a_size;
+
+    if( checksum ) {
+        header->checksum = system_checksum( file->a, a_size, file->b, b_size );
+        header->flags |= GSYS_CHECKSUM;
+    }
+    int ok = msync( file->mapping, file->mapping_size, MS_SYNC ) == 0;
+    gsys_unmap( file );
+    return ok ? gsys_success : gsys_io_error;
+}
+
+
+PUBLIC const char *gsys_result_text( enum GsysResult result )
+{
+    switch( result ) {
+    case gsys_success:        return "success";
+    case gsys_io_error:       return "the file could not be read or written";
+    case gsys_format_error:   return "the file is not a usable .gsys file";
+    case gsys_checksum_error: return "the data does not match its checksum";
+    default:                  return "unknown error";
+    }
+}
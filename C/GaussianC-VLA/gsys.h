@@ -0,0 +1,97 @@
+/*!
+ * \file   gsys.h
+ * \brief  Interface to the binary system file format (.gsys).
+ *
+ * A .gsys file is a 64 byte header followed by the matrix of coefficients and then the driving
+ * vectors, each in row-major order with elements of the type named in the header. Because the
+ * header is 64 bytes and a mapping starts on a page boundary, a mapped file can be handed to the
+ * solver as it stands: the matrix is already an array of rows, aligned for any vector load.
+ *
+ * Files are written in the byte order of the machine that writes them. A reader with a different
+ * byte order, or with a different size for the element type, rejects the file.
+ */
+
+#ifndef GSYS_H
+#define GSYS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "gaussian.h"
+
+#define GSYS_VERSION    1
+#define GSYS_BYTE_ORDER 0x01020304u
+
+// Layouts of the data following the header.
+#define GSYS_LAYOUT_SEPARATE 0  // The size x size matrix, then the size x rhs_count driving vectors.
+
+// Flags.
+#define GSYS_CHECKSUM 0x1       // The checksum field is valid.
+
+struct GsysHeader {
+    char     magic[4];          // "GSYS"
+    uint32_t version;           // GSYS_VERSION
+    uint32_t byte_order;        // GSYS_BYTE_ORDER as stored by the writer.
+    uint32_t element_type;      // An enum GaussianPrecision.
+    uint32_t element_size;      // The size of one element on the writer.
+    uint32_t layout;            // One of the GSYS_LAYOUT_ values.
+    uint64_t size;              // The number of unknowns.
+    uint64_t rhs_count;         // The number of driving vectors.
+    uint64_t checksum;          // Of the matrix and driving vectors (see gsys.c).
+    uint32_t flags;             // GSYS_ flags.
+    char     reserved[12];      // Zero.
+};
+
+enum GsysResult {
+    gsys_success,
+    gsys_io_error,              // The file could not be opened, read, written, or mapped.
+    gsys_format_error,          // The file is not a .gsys file this program can use.
+    gsys_checksum_error         // The data does not match the checksum in the header.
+};
+
+// A mapped .gsys file.
+typedef struct {
+    void   *mapping;
+    size_t  mapping_size;
+    enum GaussianPrecision precision;
+    size_t  size;
+    size_t  rhs_count;
+    void   *a;                  // Points into the mapping at the matrix.
+    void   *b;                  // Points into the mapping at the driving vectors.
+} GsysFile;
+
+//! Returns nonzero if the named file starts with the .gsys magic number.
+int gsys_is_gsys( const char *path );
+
+//! Maps a .gsys file into memory. The file is not copied.
+/*!
+ * The mapping is private: the solver may modify a and b in place, and the pages it writes are
+ * copied by the operating system as it writes them, but the file itself never changes. If
+ * 'verify' is nonzero and the file has a checksum, the checksum is checked (which reads every
+ * page of the file).
+ */
+enum GsysResult gsys_map( const char *path, int verify, GsysFile *file );
+
+//! Releases a mapping made by gsys_map.
+void gsys_unmap( GsysFile *file );
+
+//! Writes a system to a .gsys file, with a checksum if 'checksum' is nonzero.
+enum GsysResult gsys_write( const char *path, enum GaussianPrecision precision, size_t size, size_t rhs_count, const void *a, const void *b, int checksum );
+
+//! Creates a .gsys file of the given shape and maps it for writing.
+/*!
+ * The caller fills in file->a and file->b (in place, from any number of threads) and then calls
+ * gsys_finish. This writes large systems without holding a second copy in memory.
+ */
+enum GsysResult gsys_create( const char *path, enum GaussianPrecision precision, size_t size, size_t rhs_count, GsysFile *file );
+
+//! Completes a file made by gsys_create, with a checksum if 'checksum' is nonzero, and unmaps it.
+enum GsysResult gsys_finish( GsysFile *file, int checksum );
+
+//! Returns the checksum of count bytes starting at data.
+uint64_t gsys_checksum( const void *data, size_t count );
+
+//! Returns a description of a result for error messages.
+const char *gsys_result_text( enum GsysResult result );
+
+#endif
@@ -0,0 +1,92 @@
+/*!
+ * \file   huge_pages.c
+ * \brief  Allocation of large blocks on huge pages.
+ *
+ * Where mmap has no huge page options (Cygwin, for one) blocks are simply mapped on ordinary
+ * pages.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "huge_pages.h"
+
+// Some C libraries know how to ask for a particular huge page size but don't name this one.
+#if defined(MAP_HUGETLB) && !defined(MAP_HUGE_2MB) && defined(MAP_HUGE_SHIFT)
+#define MAP_HUGE_2MB ( 21 << MAP_HUGE_SHIFT )
+#endif
+
+// For profiling, it is best for all functions to be public.
+#define PRIVATE // static
+#define PUBLIC
+
+//! Returns the number of bytes actually mapped for a block of 'bytes' bytes.
+PRIVATE size_t huge_pages_length( size_t bytes )
+{
+    // Whole huge pages are mapped so a hugetlbfs block can be unmapped the same way.
+    return ( bytes + HUGE_PAGE_SIZE - 1 ) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+}
+
+
+//! Returns nonzero if the kernel will back blocks marked MADV_HUGEPAGE with transparent huge pages.
+PRIVATE int huge_pages_transparent( void )
+{
+    char  setting[64] = "";
+    FILE *file = fopen( "/sys/kernel/mm/transparent_hugepage/enabled", "r" );
+
+    if( file == NULL ) return 0;
+    if( fgets( setting, sizeof( setting ), file ) == NULL ) setting[0] = '\0';
+    fclose( file );
+
+    // The current choice is in brackets: "always [madvise] never".
+    return strstr( setting, "[always]" ) != NULL || strstr( setting, "[madvise]" ) != NULL;
+}
+
+
+PUBLIC void *huge_pages_allocate( size_t bytes, size_t *page_size )
+{
+    size_t length = huge_pages_length( bytes );
+    size_t dummy;
+    char  *block;
+
+    if( page_size == NULL ) page_size = &dummy;
+    *page_size = (size_t)sysconf( _SC_PAGESIZE );
+
+    // Reserved huge pages are certain to be huge, but few systems have any set aside.
+    #ifdef MAP_HUGETLB
+    int huge_flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+    #ifdef MAP_HUGE_2MB
+    huge_flags |= MAP_HUGE_2MB;   // Not the default size, which may be 1 GB.
+    #endif
+    block = (char *)mmap( NULL, length, PROT_READ | PROT_WRITE, huge_flags, -1, 0 );
+    if( block != MAP_FAILED ) {
+        *page_size = HUGE_PAGE_SIZE;
+        return block;
+    }
+    #endif
+
+    // Otherwise map one huge page more than needed and trim it so the block starts on a huge
+    // page boundary. Unaligned, the first and last few megabytes could never be huge pages.
+    size_t padded = length + HUGE_PAGE_SIZE;
+    char  *mapping = (char *)mmap( NULL, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+    if( mapping == MAP_FAILED ) return NULL;
+
+    block = (char *)( ( (size_t)mapping + HUGE_PAGE_SIZE - 1 ) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE );
+    if( block > mapping ) munmap( mapping, (size_t)( block - mapping ) );
+    if( mapping + padded > block + length ) munmap( block + length, (size_t)( mapping + padded - ( block + length ) ) );
+
+    #ifdef MADV_HUGEPAGE
+    if( madvise( block, length, MADV_HUGEPAGE ) == 0 && huge_pages_transparent( ) ) {
+        *page_size = HUGE_PAGE_SIZE;
+    }
+    #endif
+    return block;
+}
+
+
+PUBLIC void huge_pages_free( void *block, size_t bytes )
+{
+    if( block != NULL ) munmap( block, huge_pages_length( bytes ) );
+}
@@ -0,0 +1,32 @@
+/*!
+ * \file   huge_pages.h
+ * \brief  Interface to the allocation of large blocks on huge pages.
+ *
+ * A large matrix on 4 KB pages needs a TLB entry for every 4 KB, so walking down a column takes a
+ * TLB miss per row once the matrix is bigger than the TLB reaches. On 2 MB pages one entry
+ * covers hundreds of rows. Blocks from huge_pages_allocate come from reserved huge pages if the
+ * system has any (hugetlbfs), and otherwise are 2 MB aligned and marked for transparent huge
+ * pages. If neither is available they are ordinary pages.
+ */
+
+#ifndef HUGE_PAGES_H
+#define HUGE_PAGES_H
+
+#include <stddef.h>
+
+// The size of the huge pages asked for.
+#define HUGE_PAGE_SIZE ( (size_t)2 * 1024 * 1024 )
+
+//! Allocates a block of 'bytes' bytes, zeroed, on the largest pages available.
+/*!
+ * Puts the size of the pages backing the block in *page_size, if page_size is not NULL. For
+ * transparent huge pages that is the size the kernel will use when it can; it may still fall
+ * back to small pages for parts of the block when memory is fragmented. Returns NULL if the
+ * memory can't be had. Release the block with huge_pages_free.
+ */
+void *huge_pages_allocate( size_t bytes, size_t *page_size );
+
+//! Releases a block of 'bytes' bytes returned by huge_pages_allocate.
+void huge_pages_free( void *block, size_t bytes );
+
+#endif
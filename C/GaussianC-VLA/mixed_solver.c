@@ -0,0 +1,223 @@
+/*!
+ * \file   mixed_solver.c
+ * \brief  A solver that factors in single precision and refines the solution in double.
+ *
+ * Each step of the refinement computes the residual R = B - A X in double precision, solves
+ * A D = R with the single-precision factors, and adds D to X. The factoring is the O(n^3) part;
+ * a step of refinement is O(n^2 m). When the matrix is well conditioned a few steps recover the
+ * accuracy lost to the single-precision factors. The test for convergence is the one LAPACK
+ * uses in dsgesv.
+ */
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mixed_solver.h"
+#include "phase_timing.h"
+#include "precision.h"
+#include "row_kernels.h"
+
+// For profiling, it is best for all functions to be public.
+#define PRIVATE // static
+#define PUBLIC
+
+// The refinement gives up after this many steps.
+#ifndef MIXED_ITERATIONS
+#define MIXED_ITERATIONS 30
+#endif
+
+//! Returns the dot product of x and y. The partial sums are independent so they can be vectorized.
+PRIVATE float single_dot( size_t count, const float * restrict x, const float * restrict y )
+{
+    float  partial[8] = { 0.0f };
+    float  sum = 0.0f;
+    size_t k = 0;
+
+    for( ; k + 8 <= count; k += 8 ) {
+        for( size_t l = 0; l < 8; ++l ) {
+            partial[l] += x[k + l] * y[k + l];
+        }
+    }
+    for( ; k < count; ++k ) {
+        sum += x[k] * y[k];
+    }
+    for( size_t l = 0; l < 8; ++l ) {
+        sum += partial[l];
+    }
+    return sum;
+}
+
+//! Returns the dot product of x and y in double precision, as single_dot does.
+PRIVATE floating_type double_dot( size_t count, const floating_type * restrict x, const floating_type * restrict y )
+{
+    floating_type partial[8] = { 0.0 };
+    floating_type sum = 0.0;
+    size_t        k = 0;
+
+    for( ; k + 8 <= count; k += 8 ) {
+        for( size_t l = 0; l < 8; ++l ) {
+            partial[l] += x[k + l] * y[k + l];
+        }
+    }
+    for( ; k < count; ++k ) {
+        sum += x[k] * y[k];
+    }
+    for( size_t l = 0; l < 8; ++l ) {
+        sum += partial[l];
+    }
+    return sum;
+}
+
+//! Solves L U D = P R with the single-precision factors and adds D to X. O(n^2 m)
+PRIVATE void single_correction( size_t size, float *const *a, const size_t *pivots, size_t rhs_count, const floating_type * restrict r, float * restrict d, floating_type * restrict x )
+{
+    size_t i, c;
+
+    for( i = 0; i < size; ++i ) {
+        for( c = 0; c < rhs_count; ++c ) {
+            d[i * rhs_count + c] = (float)r[pivots[i] * rhs_count + c];
+        }
+    }
+
+    // A single driving vector is done a row at a time with dot products.
+    if( rhs_count == 1 ) {
+        for( i = 1; i < size; ++i ) {
+            d[i] -= single_dot( i, a[i], d );
+        }
+        for( i = size; i-- > 0; ) {
+            d[i] = ( d[i] - single_dot( size - i - 1, &a[i][i + 1], &d[i + 1] ) ) / a[i][i];
+        }
+    }
+    else {
+        precision_substitution_float( size, a, rhs_count, d );
+    }
+
+    for( i = 0; i < size * rhs_count; ++i ) {
+        x[i] += d[i];
+    }
+}
+
+//! Computes R = B - A X in double precision. O(n^2 m)
+PRIVATE void residual( size_t size, size_t lda, size_t rhs_count, const floating_type * restrict a, const floating_type * restrict b, const floating_type * restrict x, floating_type * restrict r )
+{
+    size_t i, j;
+
+    for( i = 0; i < size; ++i ) {
+        const floating_type *a_row = &a[i * lda];
+        floating_type       *r_row = &r[i * rhs_count];
+
+        if( rhs_count == 1 ) {
+            r_row[0] = b[i] - double_dot( size, a_row, x );
+        }
+        else {
+            memcpy( r_row, &b[i * rhs_count], rhs_count * sizeof( floating_type ) );
+            for( j = 0; j < size; ++j ) {
+                row_axpy( rhs_count, a_row[j], &x[j * rhs_count], r_row );
+            }
+        }
+    }
+}
+
+//! Returns nonzero if every column of R is small compared with the same column of X.
+/*!
+ * Column c has converged when max |R[i][c]| <= max |X[i][c]| * limit.
+ */
+PRIVATE int converged( size_t size, size_t rhs_count, const floating_type *x, const floating_type *r, floating_type limit )
+{
+    size_t i, c;
+
+    for( c = 0; c < rhs_count; ++c ) {
+        floating_type r_norm = 0.0;
+        floating_type x_norm = 0.0;
+        for( i = 0; i < size; ++i ) {
+            if( fabs( r[i * rhs_count + c] ) > r_norm ) r_norm = fabs( r[i * rhs_count + c] );
+            if( fabs( x[i * rhs_count + c] ) > x_norm ) x_norm = fabs( x[i * rhs_count + c] );
+        }
+        // Written so that a NaN in the residual counts as not converged.
+        if( !( r_norm <= x_norm * limit ) ) return 0;
+    }
+    return 1;
+}
+
+
+PUBLIC enum GaussianResult mixed_solve( size_t size, size_t lda, size_t rhs_count, const floating_type * restrict a, floating_type * restrict b )
+{
+    enum GaussianResult return_code;
+    floating_type a_norm = 0.0;
+    size_t i, j;
+    int    iteration;
+
+    GaussianProfile *profile = phase_current_profile;
+    double time = phase_clock( profile );
+    phase_team( profile, 1 );
+
+    // The matrix can't be factored in single precision if its elements don't fit in a float.
+    // Otherwise its (infinity) norm scales the test for convergence.
+    for( i = 0; i < size; ++i ) {
+        floating_type row_sum = 0.0;
+        for( j = 0; j < size; ++j ) {
+            if( !( fabs( a[i * lda + j] ) <= FLT_MAX ) ) return gaussian_error;
+            row_sum += fabs( a[i * lda + j] );
+        }
+        if( row_sum > a_norm ) a_norm = row_sum;
+    }
+
+    // LAPACK scales by sqrt( size ). The integer square root does as well and keeps libm out.
+    size_t root = 1;
+    while( ( root + 1 ) * ( root + 1 ) <= size ) ++root;
+    floating_type limit = a_norm * DBL_EPSILON * (floating_type)root;
+
+    // The single-precision copy is padded too, so its columns don't share a cache set.
+    size_t  factors_lda = gaussian_leading_dimension( size, sizeof( float ) );
+    float  *factors = (float *)aligned_alloc( 64, size * factors_lda * sizeof( float ) );
+    float **rows = (float **)malloc( size * sizeof( float * ) );
+    size_t *pivots = (size_t *)malloc( size * sizeof( size_t ) );
+    float  *d = (float *)malloc( size * rhs_count * sizeof( float ) );
+    floating_type *x = (floating_type *)calloc( size * rhs_count, sizeof( floating_type ) );
+    floating_type *r = (floating_type *)malloc( size * rhs_count * sizeof( floating_type ) );
+
+    for( i = 0; i < size; ++i ) {
+        for( j = 0; j < size; ++j ) {
+            factors[i * factors_lda + j] = (float)a[i * lda + j];
+        }
+        rows[i] = &factors[i * factors_lda];
+    }
+
+    // Like the tiled strategy's copies, making the single-precision copy counts as moving rows.
+    time = phase_charge( profile, 0, phase_row_swap, time );
+
+    // The single-precision elimination times its own phases.
+    return_code = precision_elimination_float( size, rows );
+    time = phase_clock( profile );
+    if( return_code == gaussian_success ) {
+        for( i = 0; i < size; ++i ) {
+            pivots[i] = (size_t)( rows[i] - factors ) / factors_lda;
+        }
+
+        // Starting from X = 0 the first residual is B itself.
+        memcpy( r, b, size * rhs_count * sizeof( floating_type ) );
+        return_code = gaussian_degenerate;
+        for( iteration = 0; iteration <= MIXED_ITERATIONS; ++iteration ) {
+            single_correction( size, rows, pivots, rhs_count, r, d, x );
+            time = phase_charge( profile, 0, phase_substitution, time );
+            residual( size, lda, rhs_count, a, b, x, r );
+            int done = converged( size, rhs_count, x, r, limit );
+            time = phase_charge( profile, 0, phase_refinement, time );
+            if( done ) {
+                memcpy( b, x, size * rhs_count * sizeof( floating_type ) );
+                return_code = gaussian_success;
+                break;
+            }
+        }
+    }
+
+    free( r );
+    free( x );
+    free( d );
+    free( pivots );
+    free( rows );
+    free( factors );
+    return return_code;
+}
@@ -0,0 +1,27 @@
+/*!
+ * \file   mixed_solver.h
+ * \brief  Interface to the mixed-precision solver.
+ *
+ * The matrix is factored in single precision, which moves half as many bytes and fits twice as
+ * many elements in a vector register, and the solution is then brought to double precision
+ * accuracy by iterative refinement. gaussian_solve uses it for selection 7.
+ */
+
+#ifndef MIXED_SOLVER_H
+#define MIXED_SOLVER_H
+
+#include <stddef.h>
+
+#include "gaussian.h"
+
+//! Solves a system by single-precision factoring and double-precision refinement.
+/*!
+ * The arguments are as for gaussian_solve, with a and b as size x size and size x rhs_count
+ * matrices in row-major order, the rows of a lda elements apart. The matrix of coefficients is
+ * never modified, and the driving vectors are only replaced with the solutions if this function
+ * succeeds. It fails if the matrix can't be factored in single precision or the refinement
+ * doesn't converge, leaving the caller to solve the system in double precision instead.
+ */
+enum GaussianResult mixed_solve( size_t size, size_t lda, size_t rhs_count, const floating_type * restrict a, floating_type * restrict b );
+
+#endif
@@ -0,0 +1,71 @@
+/*!
+ * \file   phase_timing.c
+ * \brief  Timing of the phases of the elimination.
+ */
+
+#include <string.h>
+
+#include "phase_timing.h"
+
+// For profiling, it is best for all functions to be public.
+#define PRIVATE // static
+#define PUBLIC
+
+PUBLIC _Thread_local GaussianProfile *phase_current_profile = NULL;
+
+static const char *phase_names[phase_count] = {
+    "pivot search", "row swap", "row update", "synchronization", "substitution", "refinement"
+};
+
+
+PUBLIC void gaussian_profile_begin( GaussianProfile *profile )
+{
+    memset( profile, 0, sizeof( GaussianProfile ) );
+    phase_current_profile = profile;
+}
+
+
+PUBLIC void gaussian_profile_end( void )
+{
+    phase_current_profile = NULL;
+}
+
+
+PUBLIC void gaussian_profile_report( const GaussianProfile *profile, FILE *output )
+{
+    double totals[phase_count] = { 0.0 };
+    int    thread_count = ( profile->thread_count > 0 ) ? profile->thread_count : 1;
+    int    h, p;
+
+    fprintf( output, "Phase times in milliseconds over %d solve(s) with up to %d thread(s)\n",
+             profile->solve_count, thread_count );
+    fprintf( output, "%8s", "thread" );
+    for( p = 0; p < phase_count; ++p ) fprintf( output, " %16s", phase_names[p] );
+    fprintf( output, "\n" );
+
+    for( h = 0; h < thread_count; ++h ) {
+        fprintf( output, "%8d", h );
+        for( p = 0; p < phase_count; ++p ) {
+            fprintf( output, " %16.3f", profile->threads[h].seconds[p] * 1000.0 );
+            totals[p] += profile->threads[h].seconds[p];
+        }
+        fprintf( output, "\n" );
+    }
+    fprintf( output, "%8s", "total" );
+    for( p = 0; p < phase_count; ++p ) fprintf( output, " %16.3f", totals[p] * 1000.0 );
+    fprintf( output, "\n" );
+
+    // The threads share the row updates, so the slowest of them sets the pace. Everyone else
+    // waits for it, and that waiting is what the imbalance measures.
+    double slowest = 0.0;
+    for( h = 0; h < thread_count; ++h ) {
+        if( profile->threads[h].seconds[phase_row_update] > slowest ) {
+            slowest = profile->threads[h].seconds[phase_row_update];
+        }
+    }
+    fprintf( output, "Time in the solver: %.3f ms\n", profile->elapsed * 1000.0 );
+    if( totals[phase_row_update] > 0.0 ) {
+        fprintf( output, "Load imbalance (slowest / mean row update time): %.3f\n",
+                 slowest / ( totals[phase_row_update] / thread_count ) );
+    }
+}
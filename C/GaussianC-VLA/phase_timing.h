@@ -0,0 +1,97 @@
+/*!
+ * \file   phase_timing.h
+ * \brief  Interface to the timing of the phases of the elimination.
+ *
+ * A caller that wants to know where the time goes hands a GaussianProfile to
+ * gaussian_profile_begin. Every solve that thread makes until gaussian_profile_end then adds the
+ * time each thread spends in each phase to the profile. When no profile is active the
+ * instrumentation costs one test of a pointer per phase; the clock is not read at all.
+ */
+
+#ifndef PHASE_TIMING_H
+#define PHASE_TIMING_H
+
+#include <stdio.h>
+#include <time.h>
+
+// The most threads whose times are kept separately. Threads beyond these are not recorded.
+#define GAUSSIAN_PROFILE_THREADS 256
+
+//! The phases of a solve.
+enum GaussianPhase {
+    phase_pivot_search,      // Finding the pivot and checking it.
+    phase_row_swap,          // Exchanging rows.
+    phase_row_update,        // Recording multipliers and updating rows, including matrix-matrix updates.
+    phase_synchronization,   // Handing out work and waiting for other threads.
+    phase_substitution,      // Forward and back substitution.
+    phase_refinement,        // Residuals and convergence tests of iterative refinement.
+    phase_count
+};
+
+//! The times of one thread. Each has its own cache line so the threads don't disturb each other.
+typedef struct {
+    _Alignas(64) double seconds[phase_count];
+} GaussianThreadTimes;
+
+//! The times accumulated over any number of solves.
+typedef struct {
+    int    solve_count;      // Number of solves timed.
+    int    thread_count;     // Largest number of threads used by any of them.
+    double elapsed;          // Total time in gaussian_solve, in seconds.
+    GaussianThreadTimes threads[GAUSSIAN_PROFILE_THREADS];
+} GaussianProfile;
+
+//! Clears the profile and times the solves made by the calling thread in it.
+void gaussian_profile_begin( GaussianProfile *profile );
+
+//! Stops timing the solves made by the calling thread.
+void gaussian_profile_end( void );
+
+//! Writes the times in the profile per phase and per thread, with the load imbalance.
+void gaussian_profile_report( const GaussianProfile *profile, FILE *output );
+
+// The rest is for the solvers.
+
+//! The profile of the calling thread, or NULL if its solves are not being timed.
+extern _Thread_local GaussianProfile *phase_current_profile;
+
+//! Returns the time in seconds if there is a profile. Otherwise returns zero without the clock.
+static inline double phase_clock( const GaussianProfile *profile )
+{
+    if( profile == NULL ) return 0.0;
+
+    struct timespec now;
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return now.tv_sec + now.tv_nsec * 1.0E-9;
+}
+
+//! Adds 'seconds' to the time a thread has spent in a phase.
+static inline void phase_add( GaussianProfile *profile, int thread, enum GaussianPhase phase, double seconds )
+{
+    if( profile == NULL ) return;
+
+    if( thread < GAUSSIAN_PROFILE_THREADS ) {
+        profile->threads[thread].seconds[phase] += seconds;
+    }
+}
+
+//! Charges the time since 'start' to a phase of a thread and returns the time now.
+static inline double phase_charge( GaussianProfile *profile, int thread, enum GaussianPhase phase, double start )
+{
+    if( profile == NULL ) return 0.0;
+
+    double now = phase_clock( profile );
+    phase_add( profile, thread, phase, now - start );
+    return now;
+}
+
+//! Notes that a solve is using 'thread_count' threads.
+static inline void phase_team( GaussianProfile *profile, int thread_count )
+{
+    if( profile == NULL ) return;
+
+    if( thread_count > GAUSSIAN_PROFILE_THREADS ) thread_count = GAUSSIAN_PROFILE_THREADS;
+    if( thread_count > profile->thread_count ) profile->thread_count = thread_count;
+}
+
+#endif
@@ -0,0 +1,155 @@
+/*!
+ * \file   placement.c
+ * \brief  Thread pinning and first-touch placement of matrices.
+ *
+ * Where the C library offers no way to set affinity, pinning quietly does nothing and memory
+ * is placed wherever the system puts it.
+ */
+
+#define _GNU_SOURCE       // For CPU_SET and pthread_setaffinity_np( ).
+
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "WorkerTeam.h"
+#include "placement.h"
+
+// For profiling, it is best for all functions to be public.
+#define PRIVATE // static
+#define PUBLIC
+
+// Structure to define the rows placed by a single thread.
+struct PlacementWorkUnit {
+    char       *block;
+    const char *source;
+    size_t      rows;
+    size_t      row_bytes;
+    size_t      source_row_bytes;
+    size_t      band_rows;
+    int         member;
+    int         team_size;
+};
+
+
+PUBLIC int placement_cpu( int member, int team_size )
+{
+    #if defined(__GLIBC__) || defined(__CYGWIN__)
+    cpu_set_t allowed;
+    int       count = 0;
+
+    if( sched_getaffinity( 0, sizeof( allowed ), &allowed ) != 0 ) return member;
+
+    // Take the (member * CPU_COUNT / team_size)th allowed processor.
+    int wanted = (int)( (long)member * CPU_COUNT( &allowed ) / team_size );
+    for( int cpu = 0; cpu < CPU_SETSIZE; ++cpu ) {
+        if( CPU_ISSET( cpu, &allowed ) && count++ == wanted ) return cpu;
+    }
+    #endif
+    return member;
+}
+
+
+PUBLIC size_t placement_band_rows( size_t row_bytes )
+{
+    size_t page_size = (size_t)sysconf( _SC_PAGESIZE );
+    size_t a = page_size, b = row_bytes;
+
+    // page_size / gcd( page_size, row_bytes ) rows are the fewest that end on a page boundary.
+    while( b != 0 ) {
+        size_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return page_size / a;
+}
+
+
+PUBLIC int placement_pin( int member, int team_size )
+{
+    #if defined(__GLIBC__) || defined(__CYGWIN__)
+    cpu_set_t target;
+    CPU_ZERO( &target );
+    CPU_SET( placement_cpu( member, team_size ), &target );
+    return pthread_setaffinity_np( pthread_self( ), sizeof( target ), &target ) == 0;
+    #else
+    return 0;
+    #endif
+}
+
+
+//! Pins the thread and touches the bands of rows it owns.
+PRIVATE void *placement_work( void *arg )
+{
+    struct PlacementWorkUnit *unit = (struct PlacementWorkUnit *)arg;
+    const size_t step = unit->band_rows * unit->team_size;
+
+    placement_pin( unit->member, unit->team_size );
+    for( size_t r = unit->member * unit->band_rows; r < unit->rows; r += step ) {
+        size_t count = ( unit->rows - r < unit->band_rows ) ? unit->rows - r : unit->band_rows;
+        if( unit->source != NULL && unit->source_row_bytes == unit->row_bytes ) {
+            memcpy( unit->block + r * unit->row_bytes, unit->source + r * unit->row_bytes, count * unit->row_bytes );
+        }
+        else if( unit->source != NULL ) {
+            // The source is packed more tightly, so each row is copied and then padded.
+            for( size_t i = r; i < r + count; ++i ) {
+                memcpy( unit->block + i * unit->row_bytes, unit->source + i * unit->source_row_bytes, unit->source_row_bytes );
+                memset( unit->block + i * unit->row_bytes + unit->source_row_bytes, 0, unit->row_bytes - unit->source_row_bytes );
+            }
+        }
+        else {
+            memset( unit->block + r * unit->row_bytes, 0, count * unit->row_bytes );
+        }
+    }
+    return NULL;
+}
+
+
+PUBLIC void *placement_allocate( size_t rows, size_t row_bytes, int team_size, const void *source, size_t source_row_bytes )
+{
+    // The pages must be fresh for first touch to decide where they go, so the block comes
+    // straight from the system rather than from malloc.
+    void *block = mmap( NULL, rows * row_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+    if( block == MAP_FAILED ) return NULL;
+
+    // A huge page would span many bands and go wherever the first of them is touched.
+    #ifdef MADV_NOHUGEPAGE
+    madvise( block, rows * row_bytes, MADV_NOHUGEPAGE );
+    #endif
+
+    struct PlacementWorkUnit units[team_size];
+    for( int h = 0; h < team_size; ++h ) {
+        units[h].block = (char *)block;
+        units[h].source = (const char *)source;
+        units[h].rows = rows;
+        units[h].row_bytes = row_bytes;
+        units[h].source_row_bytes = source_row_bytes;
+        units[h].band_rows = placement_band_rows( row_bytes );
+        units[h].member = h;
+        units[h].team_size = team_size;
+    }
+
+    // The calling thread is member 0 of the team, so its affinity is put back afterwards.
+    #if defined(__GLIBC__) || defined(__CYGWIN__)
+    cpu_set_t original;
+    int restore = pthread_getaffinity_np( pthread_self( ), sizeof( original ), &original ) == 0;
+    #endif
+
+    WorkerTeam team;
+    WorkerTeam_initialize( &team, team_size );
+    WorkerTeam_run( &team, placement_work, units, sizeof( struct PlacementWorkUnit ) );
+    WorkerTeam_destroy( &team );
+
+    #if defined(__GLIBC__) || defined(__CYGWIN__)
+    if( restore ) pthread_setaffinity_np( pthread_self( ), sizeof( original ), &original );
+    #endif
+    return block;
+}
+
+
+PUBLIC void placement_free( void *block, size_t rows, size_t row_bytes )
+{
+    if( block != NULL ) munmap( block, rows * row_bytes );
+}
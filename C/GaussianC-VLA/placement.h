@@ -0,0 +1,55 @@
+/*!
+ * \file   placement.h
+ * \brief  Interface to thread pinning and first-touch placement of matrices.
+ *
+ * On a machine with more than one memory node a page lives on the node of the thread that first
+ * touches it. A solver that wants each thread's rows in that thread's local memory therefore pins
+ * its threads to processors and has each thread touch its own rows first. The two sides must
+ * agree on who owns what, and member h of a team of T threads runs on placement_cpu( h, T ).
+ *
+ * A page can only be local to one thread, so rows are owned in bands that start and end on page
+ * boundaries: band b is rows [b * B, (b + 1) * B), with B from placement_band_rows, and member h
+ * owns the bands b with b % T == h. A padded row (see gaussian_leading_dimension) is an odd number
+ * of cache lines, so a band is 64 rows of doubles. Dealing the bands out in turn keeps the work
+ * of the elimination roughly even as its top rows are finished, but a matrix with only a few bands
+ * per thread is unevenly shared. Such a matrix is small enough that placement doesn't matter.
+ */
+
+#ifndef PLACEMENT_H
+#define PLACEMENT_H
+
+#include <stddef.h>
+
+//! Returns the number of rows of row_bytes bytes in a band: the fewest that fill whole pages.
+size_t placement_band_rows( size_t row_bytes );
+
+//! Returns the member of a team of team_size threads that owns 'row', for bands of band_rows rows.
+static inline int placement_owner( size_t row, size_t band_rows, int team_size )
+{
+    return (int)( ( row / band_rows ) % (size_t)team_size );
+}
+
+//! Returns the processor for member 'member' of a team of 'team_size' threads.
+/*!
+ * The members are spread evenly over the processors the program may use, so a team smaller than
+ * the machine still reaches every memory node.
+ */
+int placement_cpu( int member, int team_size );
+
+//! Pins the calling thread to placement_cpu( member, team_size ). Returns nonzero on success.
+int placement_pin( int member, int team_size );
+
+//! Allocates rows * row_bytes bytes with each row first touched by the thread that owns it.
+/*!
+ * A team of team_size pinned threads copies each row from 'source', or zeroes it if source is
+ * NULL, on the member that owns it. The rows of source are source_row_bytes apart, which may be
+ * less than row_bytes; the rest of each row is then zeroed. The block is kept on small pages, so
+ * no page is shared by two bands. Returns NULL if the memory can't be had. Release the block with
+ * placement_free.
+ */
+void *placement_allocate( size_t rows, size_t row_bytes, int team_size, const void *source, size_t source_row_bytes );
+
+//! Releases a block returned by placement_allocate.
+void placement_free( void *block, size_t rows, size_t row_bytes );
+
+#endif
@@ -0,0 +1,84 @@
+/*!
+ * \file   precision.c
+ * \brief  The elimination engine instantiated for each supported precision.
+ *
+ * Double precision is handled by gaussian_solve, which instantiates the same engine for itself
+ * and adds the strategies that only exist in double. The other precisions get the serial,
+ * p_thread, and blocked strategies of precision_template.h.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "WorkerTeam.h"
+#include "gaussian.h"
+#include "phase_timing.h"
+#include "precision.h"
+#include "row_kernels.h"
+
+// For profiling, it is best for all functions to be public.
+#define PRIVATE // static
+#define PUBLIC
+
+#define PRECISION_TYPE float
+#define PRECISION_SUFFIX float
+#define PRECISION_AXPY row_axpy_float
+#include "precision_template.h"
+
+#define PRECISION_TYPE long double
+#define PRECISION_SUFFIX long_double
+#include "precision_template.h"
+
+#ifdef GAUSSIAN_HAVE_FLOAT128
+#define PRECISION_TYPE __float128
+#define PRECISION_SUFFIX float128
+#include "precision_template.h"
+#endif
+
+
+PUBLIC size_t gaussian_precision_size( enum GaussianPrecision precision )
+{
+    switch( precision ) {
+    case precision_float:       return sizeof( float );
+    case precision_double:      return sizeof( double );
+    case precision_long_double: return sizeof( long double );
+    #ifdef GAUSSIAN_HAVE_FLOAT128
+    case precision_float128:    return sizeof( __float128 );
+    #endif
+    default:                    return 0;
+    }
+}
+
+
+PUBLIC int gaussian_precision_has_strategy( enum GaussianPrecision precision, int selection )
+{
+    if( precision == precision_double ) return 1;
+
+    switch( selection ) {
+    case 1: case '1':
+    case 2: case '2':
+    case 5: case '5':
+        return gaussian_precision_size( precision ) != 0;
+    default:
+        return 0;
+    }
+}
+
+
+PUBLIC enum GaussianResult gaussian_solve_precision( enum GaussianPrecision precision, size_t size, size_t lda, size_t rhs_count, void * restrict a, void * restrict b, int selection, int thread_count )
+{
+    switch( precision ) {
+    case precision_float:
+        return gaussian_solve_float( size, lda, rhs_count, a, b, selection, thread_count );
+    case precision_double:
+        return gaussian_solve( size, lda, rhs_count, a, b, selection, thread_count );
+    case precision_long_double:
+        return gaussian_solve_long_double( size, lda, rhs_count, a, b, selection, thread_count );
+    #ifdef GAUSSIAN_HAVE_FLOAT128
+    case precision_float128:
+        return gaussian_solve_float128( size, lda, rhs_count, a, b, selection, thread_count );
+    #endif
+    default:
+        return gaussian_error;
+    }
+}
@@ -0,0 +1,27 @@
+/*!
+ * \file   precision.h
+ * \brief  Interface to the elimination engine in the precisions other than floating_type.
+ *
+ * The engine is written once in precision_template.h. It is instantiated in precision.c for the
+ * other precisions and in gaussian.c for floating_type. The solvers themselves are declared in
+ * gaussian.h. This header declares the pieces other parts of the program reuse.
+ */
+
+#ifndef PRECISION_H
+#define PRECISION_H
+
+#include <stddef.h>
+
+#include "gaussian.h"
+
+//! Factors the matrix reached through the row table 'a' in single precision. O(n^3)
+/*!
+ * On success the multipliers are stored below the diagonal and the table has been reordered by
+ * the pivoting.
+ */
+enum GaussianResult precision_elimination_float( size_t size, float **a );
+
+//! Solves L U X = Y in place with factors from precision_elimination_float. O(n^2 m)
+void precision_substitution_float( size_t size, float *const *a, size_t rhs_count, float * restrict y );
+
+#endif
@@ -0,0 +1,532 @@
+/*!
+ * \file   precision_template.h
+ * \brief  The elimination engine written once for any element type.
+ *
+ * This file is a template. It has no include guard and is included once per element type, by
+ * precision.c for float, long double, and __float128 and by gaussian.c for double, after defining
+ *
+ *   PRECISION_TYPE    The element type, for example float.
+ *   PRECISION_SUFFIX  The suffix on the names of the functions made for it, for example float.
+ *   PRECISION_AXPY    (optional) A function or macro with the signature of row_axpy for the
+ *                     type. Without it a plain loop is used.
+ *   PRECISION_PIVOT_SEARCH  (optional) A function with the signature of row_pivot_search for the
+ *                     type. Without it a plain loop is used.
+ *   PRECISION_GEMM    (optional) A function with the signature of gemm_update for the type. The
+ *                     blocked strategy uses it for its trailing updates; without it they are
+ *                     done a row at a time with PRECISION_AXPY.
+ *   PRECISION_BLOCK_SUBSTITUTION  (optional) A function with the signature of block_substitution
+ *                     in gaussian.c, used for more than one driving vector. Without it
+ *                     precision_substitution is used.
+ *   PRECISION_ENGINE_ONLY  (optional) Leave out gaussian_solve_SUFFIX. gaussian.c has its own
+ *                     solver for double, with the strategies that only exist in double.
+ *
+ * Each inclusion defines, with _SUFFIX appended to each name:
+ *
+ *   precision_elimination           The serial strategy (selection 1).
+ *   precision_threaded_elimination  The p_thread strategy (selection 2).
+ *   precision_blocked_elimination   The blocked strategy (selection 5), with the panel_factor,
+ *                                   triangular_update, and trailing_update it is built from.
+ *   precision_lu_substitution       Forward and back substitution after any of them.
+ *   gaussian_solve                  A solver offering those three strategies.
+ *
+ * and then undefines the macros so the next inclusion starts afresh. The including file must
+ * include stdlib.h, string.h, WorkerTeam.h, phase_timing.h, and gaussian.h first. Only
+ * library-free operations are used on the elements, so __float128 needs no libquadmath.
+ */
+
+#define PRECISION_JOIN2( name, suffix ) name ## _ ## suffix
+#define PRECISION_JOIN( name, suffix ) PRECISION_JOIN2( name, suffix )
+#define PRECISION_NAME( name ) PRECISION_JOIN( name, PRECISION_SUFFIX )
+#define PRECISION_ABS( x ) ( ( x ) < 0 ? -( x ) : ( x ) )
+
+// Number of columns in each panel factored by the blocked strategy. Compile with -DBLOCK_SIZE=n
+// to tune it for a particular cache hierarchy.
+#ifndef BLOCK_SIZE
+#define BLOCK_SIZE 64
+#endif
+
+#ifndef PRECISION_AXPY
+#define PRECISION_AXPY( count, m, x, y )                \
+    for( size_t k_ = 0; k_ < ( count ); ++k_ ) {        \
+        ( y )[k_] -= ( m ) * ( x )[k_];                 \
+    }
+#endif
+
+#ifndef PRECISION_PIVOT_SEARCH
+//! Returns the j in [start, stop) for which |rows[j][column]| is largest (the first, on ties).
+PRIVATE size_t PRECISION_NAME( precision_pivot_search )( PRECISION_TYPE *const *rows, size_t column, size_t start, size_t stop )
+{
+    PRECISION_TYPE best = PRECISION_ABS( rows[start][column] );
+    size_t         k = start;
+
+    for( size_t j = start + 1; j < stop; ++j ) {
+        if( PRECISION_ABS( rows[j][column] ) > best ) {
+            k = j;
+            best = PRECISION_ABS( rows[j][column] );
+        }
+    }
+    return k;
+}
+#define PRECISION_PIVOT_SEARCH PRECISION_NAME( precision_pivot_search )
+#endif
+
+//! Does the elimination step of reducing the system. O(n^3)
+/*!
+ * Like the other strategies, this leaves the LU factors of the matrix in the rows: the multipliers
+ * are stored in the columns they eliminate and the rows of U are on and above the diagonal. The
+ * order of the row table 'a' records the pivoting. The driving vectors are not touched here; see
+ * precision_lu_substitution. The last diagonal element is checked as well, so the factors can go
+ * straight to precision_substitution (see mixed_solver.c).
+ */
+PUBLIC enum GaussianResult PRECISION_NAME( precision_elimination )( size_t size, PRECISION_TYPE **a )
+{
+    PRECISION_TYPE *row;
+    PRECISION_TYPE  m;
+    size_t          i, j, k;
+
+    GaussianProfile *profile = phase_current_profile;
+    double time = phase_clock( profile );
+    phase_team( profile, 1 );
+
+    for( i = 0; i < size; ++i ) {
+
+        // Find the row with the largest value of |a[j][i]|, j = i, ..., n - 1
+        k = PRECISION_PIVOT_SEARCH( a, i, i, size );
+
+        // Check for |a[k][i]| zero.
+        // TODO: The value 1.0E-6 is arbitrary. A more disciplined value should be used.
+        if( !( PRECISION_ABS( a[k][i] ) > 1.0E-6 ) ) {
+            return gaussian_degenerate;
+        }
+        time = phase_charge( profile, 0, phase_pivot_search, time );
+
+        // Exchange row i and row k, if necessary. Only their pointers in the row table move.
+        if( k != i ) {
+            row = a[i];
+            a[i] = a[k];
+            a[k] = row;
+        }
+        time = phase_charge( profile, 0, phase_row_swap, time );
+
+        // Record the multipliers and subtract multiples of row i from subsequent rows.
+        if (i % 2 == 0) {
+            for( j = i + 1; j < size; ++j ) {
+                m = a[j][i] /= a[i][i];
+                PRECISION_AXPY( size - i - 1, m, &a[i][i + 1], &a[j][i + 1] );
+            }
+        } else {
+            for( j = size - 1; j > i; --j ) {
+                m = a[j][i] /= a[i][i];
+                PRECISION_AXPY( size - i - 1, m, &a[i][i + 1], &a[j][i + 1] );
+            }
+        }
+        time = phase_charge( profile, 0, phase_row_update, time );
+    }
+    return gaussian_success;
+}
+
+// Structure to define the data processed by a single thread.
+struct PRECISION_NAME( PThreadWorkUnit ) {
+    PRECISION_TYPE **a;
+    size_t current;
+    size_t start;
+    size_t stop;
+    size_t size;
+    GaussianProfile *profile;    // NULL unless the solve is being timed.
+    int member;                  // This unit's place in the team.
+    double update_time;          // Time taken by the last round.
+};
+
+PRIVATE void *PRECISION_NAME( precision_chunk_elimination )( void *arg )
+{
+    struct PRECISION_NAME( PThreadWorkUnit ) *unit = (struct PRECISION_NAME( PThreadWorkUnit ) *)arg;
+
+    const size_t size = unit->size;
+    const size_t current = unit->current;
+    const size_t start = unit->start;
+    const size_t stop = unit->stop;
+
+    PRECISION_TYPE **a = unit->a;
+    size_t           j;
+    PRECISION_TYPE   m;
+    double           time = phase_clock( unit->profile );
+
+    // Record the multipliers and subtract multiples of row i from subsequent rows.
+    if (start % 2 == 0) {
+        for( j = start; j < stop; ++j ) {
+            m = a[j][current] /= a[current][current];
+            PRECISION_AXPY( size - current - 1, m, &a[current][current + 1], &a[j][current + 1] );
+        }
+    } else {
+        for( j = stop - 1; j >= start; --j ) {
+            m = a[j][current] /= a[current][current];
+            PRECISION_AXPY( size - current - 1, m, &a[current][current + 1], &a[j][current + 1] );
+        }
+
+    }
+
+    unit->update_time = phase_charge( unit->profile, unit->member, phase_row_update, time ) - time;
+    return NULL;
+}
+
+//! Does the elimination step of reducing the system with a team of threads. O(n^3)
+/*!
+ * The calling thread finds each pivot and the team shares the row updates below it, a range of
+ * rows per member.
+ */
+PUBLIC enum GaussianResult PRECISION_NAME( precision_threaded_elimination )( size_t size, PRECISION_TYPE **a, int thread_count )
+{
+    int processor_count = thread_count;
+    PRECISION_TYPE *row;
+    size_t          i, k;
+    size_t  chunk_size;
+    enum GaussianResult return_code = gaussian_success;
+
+    // The team and the work units live for the whole solve. Each iteration only hands the team
+    // new ranges.
+    struct PRECISION_NAME( PThreadWorkUnit ) *ranges =
+        (struct PRECISION_NAME( PThreadWorkUnit ) *)malloc( processor_count * sizeof(struct PRECISION_NAME( PThreadWorkUnit )) );
+    if( ranges == NULL ) return gaussian_error;
+    WorkerTeam team;
+    WorkerTeam_initialize( &team, processor_count );
+    GaussianProfile *profile = phase_current_profile;
+    double time = phase_clock( profile );
+    phase_team( profile, processor_count );
+    for( size_t x = 0; x < processor_count; ++x ) {
+        ranges[x].a = a;
+        ranges[x].size = size;
+        ranges[x].profile = profile;
+        ranges[x].member = (int)x;
+    }
+
+    for( i = 0; i < size - 1; ++i ) {
+
+        // Find the row with the largest value of |a[j][i]|, j = i, ..., n - 1
+        k = PRECISION_PIVOT_SEARCH( a, i, i, size );
+
+        // Check for |a[k][i]| zero.
+        // TODO: The value 1.0E-6 is arbitrary. A more disciplined value should be used.
+        if( !( PRECISION_ABS( a[k][i] ) > 1.0E-6 ) ) {
+            return_code = gaussian_degenerate;
+            break;
+        }
+        time = phase_charge( profile, 0, phase_pivot_search, time );
+
+        // Exchange row i and row k, if necessary. Only their pointers in the row table move.
+        if( k != i ) {
+            row = a[i];
+            a[i] = a[k];
+            a[k] = row;
+        }
+        time = phase_charge( profile, 0, phase_row_swap, time );
+
+        // Split the problem.
+        size_t problem_size = ( size - ( i + 1 ));
+        chunk_size = problem_size / processor_count;
+        for( size_t x = 0; x < processor_count; ++x ) {
+            ranges[x].start = i + 1 + x * chunk_size;
+            ranges[x].stop = ranges[x].start + chunk_size;
+            ranges[x].current = i;
+        }
+        // The following line assigns the remainder elements to the last thread.
+        ranges[processor_count - 1].stop = size;
+
+        // Run the chunks on the team and wait for all of them to finish. Whatever part of the
+        // round a member didn't spend on its rows went to handing out work and waiting.
+        WorkerTeam_run( &team, PRECISION_NAME( precision_chunk_elimination ), ranges, sizeof(struct PRECISION_NAME( PThreadWorkUnit )) );
+        if( profile != NULL ) {
+            double now = phase_clock( profile );
+            for( int h = 0; h < processor_count; ++h ) {
+                phase_add( profile, h, phase_synchronization, now - time - ranges[h].update_time );
+            }
+            time = now;
+        }
+    }
+
+    // Release the team and dynamic memory.
+    WorkerTeam_destroy( &team );
+    free( ranges );
+
+    return return_code;
+}
+
+//! Factors columns [start, start + width) below row start, storing multipliers under the diagonal.
+/*!
+ * This is the unblocked elimination applied to a narrow panel of the matrix. Only the panel
+ * columns are updated; the columns to the right are brought up to date by the caller. Exchanging
+ * two rows in the row table carries the multipliers stored in earlier columns along with them.
+ */
+PUBLIC enum GaussianResult PRECISION_NAME( precision_panel_factor )( size_t size, PRECISION_TYPE **a, size_t start, size_t width )
+{
+    PRECISION_TYPE *row;
+    const size_t    stop = start + width;
+    size_t          i, j, k;
+    PRECISION_TYPE  m;
+
+    GaussianProfile *profile = phase_current_profile;
+    double time = phase_clock( profile );
+
+    for( i = start; i < stop; ++i ) {
+
+        // Find the row with the largest value of |a[j][i]|, j = i, ..., n - 1
+        k = PRECISION_PIVOT_SEARCH( a, i, i, size );
+
+        // Check for |a[k][i]| zero.
+        // TODO: The value 1.0E-6 is arbitrary. A more disciplined value should be used.
+        if( !( PRECISION_ABS( a[k][i] ) > 1.0E-6 ) ) {
+            return gaussian_degenerate;
+        }
+        time = phase_charge( profile, 0, phase_pivot_search, time );
+
+        // Exchange row i and row k, if necessary. Only their pointers in the row table move.
+        if( k != i ) {
+            row = a[i];
+            a[i] = a[k];
+            a[k] = row;
+        }
+        time = phase_charge( profile, 0, phase_row_swap, time );
+
+        // Record the multipliers and subtract multiples of row i inside the panel only.
+        for( j = i + 1; j < size; ++j ) {
+            m = a[j][i] /= a[i][i];
+            PRECISION_AXPY( stop - i - 1, m, &a[i][i + 1], &a[j][i + 1] );
+        }
+        time = phase_charge( profile, 0, phase_row_update, time );
+    }
+    return gaussian_success;
+}
+
+//! Applies the unit lower triangle at [start, start + width) to columns [first, last) of its rows.
+/*!
+ * After a panel is factored this turns the rows of the panel to its right into rows of U. O(w^2 n)
+ */
+PUBLIC void PRECISION_NAME( precision_triangular_update )( size_t size, PRECISION_TYPE **a, size_t start, size_t width, size_t first, size_t last )
+{
+    size_t i, j;
+
+    for( i = start + 1; i < start + width; ++i ) {
+        for( j = start; j < i; ++j ) {
+            PRECISION_AXPY( last - first, a[i][j], &a[j][first], &a[i][first] );
+        }
+    }
+}
+
+//! Subtracts a[rows][inner] * a[inner][columns] from a[rows][columns].
+/*!
+ * This is the matrix-matrix product that replaces a run of rank-1 updates. With PRECISION_GEMM
+ * it is handed to a packed GEMM; otherwise each row receives a multiple of every inner row while
+ * it is in cache. O(rows * columns * inner)
+ */
+PUBLIC void PRECISION_NAME( precision_trailing_update )( size_t size, PRECISION_TYPE **a, size_t row_start, size_t row_stop, size_t column_start, size_t column_stop, size_t inner_start, size_t inner_stop )
+{
+    #ifdef PRECISION_GEMM
+    PRECISION_GEMM(
+        row_stop - row_start, column_stop - column_start, inner_stop - inner_start,
+        &a[row_start], inner_start,
+        &a[inner_start], column_start,
+        &a[row_start], column_start );
+    #else
+    for( size_t i = row_start; i < row_stop; ++i ) {
+        for( size_t p = inner_start; p < inner_stop; ++p ) {
+            PRECISION_AXPY( column_stop - column_start, a[i][p], &a[p][column_start], &a[i][column_start] );
+        }
+    }
+    #endif
+}
+
+//! Does the elimination step of reducing the system one panel at a time. O(n^3)
+/*!
+ * This is a right-looking blocked LU factorization. Each panel of BLOCK_SIZE columns is factored
+ * with rank-1 updates confined to the panel, then the rest of the matrix is updated with a single
+ * matrix-matrix product. Most of the work is thus done on data that is already in cache.
+ */
+PUBLIC enum GaussianResult PRECISION_NAME( precision_blocked_elimination )( size_t size, PRECISION_TYPE **a )
+{
+    size_t start, width, stop;
+    enum GaussianResult return_code;
+
+    phase_team( phase_current_profile, 1 );
+
+    for( start = 0; start < size; start += width ) {
+        width = ( size - start < BLOCK_SIZE ) ? size - start : BLOCK_SIZE;
+        stop  = start + width;
+
+        return_code = PRECISION_NAME( precision_panel_factor )( size, a, start, width );
+        if( return_code != gaussian_success ) {
+            return return_code;
+        }
+
+        if( stop < size ) {
+            double time = phase_clock( phase_current_profile );
+            PRECISION_NAME( precision_triangular_update )( size, a, start, width, stop, size );
+            PRECISION_NAME( precision_trailing_update )( size, a, stop, size, stop, size, start, stop );
+            phase_charge( phase_current_profile, 0, phase_row_update, time );
+        }
+    }
+    return gaussian_success;
+}
+
+//! Solves L U X = Y in place, where Y (size x rhs_count) has already been permuted. O(n^2 m)
+/*!
+ * The diagonal must have been checked while factoring.
+ */
+PUBLIC void PRECISION_NAME( precision_substitution )( size_t size, PRECISION_TYPE *const *a, size_t rhs_count, PRECISION_TYPE * restrict y )
+{
+    size_t i, j, c;
+
+    for( i = 1; i < size; ++i ) {
+        for( j = 0; j < i; ++j ) {
+            PRECISION_AXPY( rhs_count, a[i][j], &y[j * rhs_count], &y[i * rhs_count] );
+        }
+    }
+    for( i = size; i-- > 0; ) {
+        for( j = i + 1; j < size; ++j ) {
+            PRECISION_AXPY( rhs_count, a[i][j], &y[j * rhs_count], &y[i * rhs_count] );
+        }
+        for( c = 0; c < rhs_count; ++c ) {
+            y[i * rhs_count + c] /= a[i][i];
+        }
+    }
+}
+
+//! Solves L U x = y in place for a single (already permuted) driving vector. O(n^2)
+PRIVATE void PRECISION_NAME( precision_vector_substitution )( size_t size, PRECISION_TYPE *const *a, PRECISION_TYPE * restrict y )
+{
+    PRECISION_TYPE sum;
+    size_t         i, j;
+
+    // Apply the stored multipliers.
+    for( i = 1; i < size; ++i ) {
+        sum = y[i];
+        for( j = 0; j < i; ++j ) {
+            sum -= a[i][j] * y[j];
+        }
+        y[i] = sum;
+    }
+
+    // Then solve with U, working up from the bottom.
+    for( i = size; i-- > 0; ) {
+        sum = y[i];
+        for( j = i + 1; j < size; ++j ) {
+            sum -= a[i][j] * y[j];
+        }
+        y[i] = sum / a[i][i];
+    }
+}
+
+//! Solves L U X = P B given the factors found by one of the strategies. O(n^2 m)
+/*!
+ * rows[i] points at row i of the factors and pivots[i] is the row of B that goes with it. B has
+ * size rows of rhs_count elements. It is permuted into a scratch matrix, solved there, and the
+ * solution is copied back. A single driving vector goes through the plain substitutions.
+ */
+PUBLIC enum GaussianResult PRECISION_NAME( precision_lu_substitution )( size_t size, PRECISION_TYPE *const *rows, const size_t *pivots, size_t rhs_count, PRECISION_TYPE * restrict b, int thread_count )
+{
+    size_t i;
+
+    if( rhs_count == 0 ) return gaussian_success;
+
+    // TODO: The value 1.0E-6 is arbitrary. A more disciplined value should be used.
+    for( i = 0; i < size; ++i ) {
+        if( !( PRECISION_ABS( rows[i][i] ) > 1.0E-6 ) ) {
+            return gaussian_degenerate;
+        }
+    }
+
+    double time = phase_clock( phase_current_profile );
+    PRECISION_TYPE *work = (PRECISION_TYPE *)malloc( size * rhs_count * sizeof( PRECISION_TYPE ) );
+    if( work == NULL ) return gaussian_error;
+    for( i = 0; i < size; ++i ) {
+        memcpy( &work[i * rhs_count], &b[pivots[i] * rhs_count], rhs_count * sizeof( PRECISION_TYPE ) );
+    }
+
+    if( rhs_count == 1 ) {
+        PRECISION_NAME( precision_vector_substitution )( size, rows, work );
+    }
+    else {
+        #ifdef PRECISION_BLOCK_SUBSTITUTION
+        PRECISION_BLOCK_SUBSTITUTION( size, rows, rhs_count, work, thread_count );
+        #else
+        (void)thread_count;
+        PRECISION_NAME( precision_substitution )( size, rows, rhs_count, work );
+        #endif
+    }
+
+    memcpy( b, work, size * rhs_count * sizeof( PRECISION_TYPE ) );
+    free( work );
+    phase_charge( phase_current_profile, 0, phase_substitution, time );
+    return gaussian_success;
+}
+
+#ifndef PRECISION_ENGINE_ONLY
+PUBLIC enum GaussianResult PRECISION_NAME( gaussian_solve )( size_t size, size_t lda, size_t rhs_count, PRECISION_TYPE (* restrict a)[lda], PRECISION_TYPE (* restrict b)[rhs_count], int selection, int thread_count )
+{
+    enum GaussianResult return_code;
+    size_t i;
+
+    // We can deal with a 1x1 system, but not an empty system.
+    if( size == 0 || lda < size ) return gaussian_error;
+
+    GaussianProfile *profile = phase_current_profile;
+    double time = phase_clock( profile );
+
+    PRECISION_TYPE **rows = (PRECISION_TYPE **)malloc( size * sizeof( PRECISION_TYPE * ) );
+    size_t *pivots = (size_t *)malloc( size * sizeof( size_t ) );
+    if( rows == NULL || pivots == NULL ) {
+        free( pivots );
+        free( rows );
+        return gaussian_error;
+    }
+    for( i = 0; i < size; ++i ) {
+        rows[i] = a[i];
+    }
+
+    thread_count = gaussian_thread_count( thread_count );
+    switch( selection ) {
+    // Serial
+    case 1:
+    case '1':
+        return_code = PRECISION_NAME( precision_elimination )( size, rows );
+        break;
+    // p_thread
+    case 2:
+    case '2':
+        return_code = PRECISION_NAME( precision_threaded_elimination )( size, rows, thread_count );
+        break;
+    // Blocked
+    case 5:
+    case '5':
+        return_code = PRECISION_NAME( precision_blocked_elimination )( size, rows );
+        break;
+
+    default:
+        return_code = gaussian_error;
+        break;
+    }
+
+    if( return_code == gaussian_success ) {
+        for( i = 0; i < size; ++i ) {
+            pivots[i] = (size_t)( rows[i] - a[0] ) / lda;
+        }
+        return_code = PRECISION_NAME( precision_lu_substitution )( size, rows, pivots, rhs_count, &b[0][0], thread_count );
+    }
+
+    free( pivots );
+    free( rows );
+
+    if( profile != NULL ) {
+        profile->solve_count += 1;
+        profile->elapsed += phase_clock( profile ) - time;
+    }
+    return return_code;
+}
+#endif
+
+#undef PRECISION_TYPE
+#undef PRECISION_SUFFIX
+#undef PRECISION_AXPY
+#undef PRECISION_PIVOT_SEARCH
+#undef PRECISION_GEMM
+#undef PRECISION_BLOCK_SUBSTITUTION
+#undef PRECISION_ENGINE_ONLY
+#undef PRECISION_NAME
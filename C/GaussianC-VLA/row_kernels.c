@@ -0,0 +1,279 @@
+/*!
+ * \file   row_kernels.c
+ * \brief  Vector kernels for the inner loops of the elimination, selected at run time.
+ *
+ * The AVX2 and AVX-512 versions are compiled with function-specific target attributes, so the
+ * rest of the program (and the scalar versions here) still only assumes the baseline instruction
+ * set. They are only ever called after the processor has been checked for the features they use.
+ * The vector versions of the floating_type kernels assume floating_type is double.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "row_kernels.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define ROW_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+// For profiling, it is best for all functions to be public.
+#define PRIVATE // static
+#define PUBLIC
+
+PRIVATE void row_axpy_scalar( size_t count, floating_type m, const floating_type * restrict x, floating_type * restrict y )
+{
+    for( size_t k = 0; k < count; ++k ) {
+        y[k] -= m * x[k];
+    }
+}
+
+PRIVATE void row_axpy_float_scalar( size_t count, float m, const float * restrict x, float * restrict y )
+{
+    for( size_t k = 0; k < count; ++k ) {
+        y[k] -= m * x[k];
+    }
+}
+
+PRIVATE size_t row_pivot_search_scalar( floating_type *const *rows, size_t column, size_t start, size_t stop )
+{
+    size_t        best_row = start;
+    floating_type best_value = fabs( rows[start][column] );
+
+    for( size_t j = start + 1; j < stop; ++j ) {
+        if( fabs( rows[j][column] ) > best_value ) {
+            best_row = j;
+            best_value = fabs( rows[j][column] );
+        }
+    }
+    return best_row;
+}
+
+
+#ifdef ROW_KERNELS_X86
+
+__attribute__(( target( "avx2,fma" ) ))
+PRIVATE void row_axpy_avx2( size_t count, floating_type m, const floating_type * restrict x, floating_type * restrict y )
+{
+    const __m256d multiplier = _mm256_set1_pd( m );
+    size_t k = 0;
+
+    // Two independent vectors per trip keep both FMA units busy.
+    for( ; k + 8 <= count; k += 8 ) {
+        __m256d y0 = _mm256_loadu_pd( &y[k] );
+        __m256d y1 = _mm256_loadu_pd( &y[k + 4] );
+        y0 = _mm256_fnmadd_pd( multiplier, _mm256_loadu_pd( &x[k] ), y0 );
+        y1 = _mm256_fnmadd_pd( multiplier, _mm256_loadu_pd( &x[k + 4] ), y1 );
+        _mm256_storeu_pd( &y[k], y0 );
+        _mm256_storeu_pd( &y[k + 4], y1 );
+    }
+    for( ; k + 4 <= count; k += 4 ) {
+        __m256d y0 = _mm256_loadu_pd( &y[k] );
+        y0 = _mm256_fnmadd_pd( multiplier, _mm256_loadu_pd( &x[k] ), y0 );
+        _mm256_storeu_pd( &y[k], y0 );
+    }
+    for( ; k < count; ++k ) {
+        y[k] -= m * x[k];
+    }
+}
+
+__attribute__(( target( "avx2,fma" ) ))
+PRIVATE void row_axpy_float_avx2( size_t count, float m, const float * restrict x, float * restrict y )
+{
+    const __m256 multiplier = _mm256_set1_ps( m );
+    size_t k = 0;
+
+    for( ; k + 16 <= count; k += 16 ) {
+        __m256 y0 = _mm256_loadu_ps( &y[k] );
+        __m256 y1 = _mm256_loadu_ps( &y[k + 8] );
+        y0 = _mm256_fnmadd_ps( multiplier, _mm256_loadu_ps( &x[k] ), y0 );
+        y1 = _mm256_fnmadd_ps( multiplier, _mm256_loadu_ps( &x[k + 8] ), y1 );
+        _mm256_storeu_ps( &y[k], y0 );
+        _mm256_storeu_ps( &y[k + 8], y1 );
+    }
+    for( ; k + 8 <= count; k += 8 ) {
+        __m256 y0 = _mm256_loadu_ps( &y[k] );
+        y0 = _mm256_fnmadd_ps( multiplier, _mm256_loadu_ps( &x[k] ), y0 );
+        _mm256_storeu_ps( &y[k], y0 );
+    }
+    for( ; k < count; ++k ) {
+        y[k] -= m * x[k];
+    }
+}
+
+//! Searches four rows at a time. The elements are gathered straight from the row pointers.
+__attribute__(( target( "avx2" ) ))
+PRIVATE size_t row_pivot_search_avx2( floating_type *const *rows, size_t column, size_t start, size_t stop )
+{
+    const __m256d sign_mask = _mm256_set1_pd( -0.0 );
+    const __m256i offset = _mm256_set1_epi64x( (long long)( column * sizeof( floating_type ) ) );
+    __m256d best_value = _mm256_set1_pd( -1.0 );
+    __m256i row = _mm256_setr_epi64x( start, start + 1, start + 2, start + 3 );
+    __m256i best_row = row;
+    const __m256i step = _mm256_set1_epi64x( 4 );
+    size_t j = start;
+
+    for( ; j + 4 <= stop; j += 4 ) {
+        __m256i address = _mm256_add_epi64( _mm256_loadu_si256( (const __m256i *)&rows[j] ), offset );
+        __m256d value = _mm256_andnot_pd( sign_mask, _mm256_i64gather_pd( (const double *)0, address, 1 ) );
+        __m256d greater = _mm256_cmp_pd( value, best_value, _CMP_GT_OQ );
+        best_value = _mm256_blendv_pd( best_value, value, greater );
+        best_row = _mm256_castpd_si256(
+            _mm256_blendv_pd( _mm256_castsi256_pd( best_row ), _mm256_castsi256_pd( row ), greater ) );
+        row = _mm256_add_epi64( row, step );
+    }
+
+    // Combine the lanes. Each lane holds the first row with its best value, so ties go to the
+    // lowest row among the lanes with the best value.
+    double    lane_value[4];
+    long long lane_row[4];
+    _mm256_storeu_pd( lane_value, best_value );
+    _mm256_storeu_si256( (__m256i *)lane_row, best_row );
+
+    size_t        result = start;
+    floating_type result_value = -1.0;
+    for( int l = 0; l < 4; ++l ) {
+        if( lane_value[l] > result_value ||
+            ( lane_value[l] == result_value && (size_t)lane_row[l] < result ) ) {
+            result = lane_row[l];
+            result_value = lane_value[l];
+        }
+    }
+    for( ; j < stop; ++j ) {
+        if( fabs( rows[j][column] ) > result_value ) {
+            result = j;
+            result_value = fabs( rows[j][column] );
+        }
+    }
+    return result;
+}
+
+__attribute__(( target( "avx512f" ) ))
+PRIVATE void row_axpy_avx512( size_t count, floating_type m, const floating_type * restrict x, floating_type * restrict y )
+{
+    const __m512d multiplier = _mm512_set1_pd( m );
+    size_t k = 0;
+
+    for( ; k + 16 <= count; k += 16 ) {
+        __m512d y0 = _mm512_loadu_pd( &y[k] );
+        __m512d y1 = _mm512_loadu_pd( &y[k + 8] );
+        y0 = _mm512_fnmadd_pd( multiplier, _mm512_loadu_pd( &x[k] ), y0 );
+        y1 = _mm512_fnmadd_pd( multiplier, _mm512_loadu_pd( &x[k + 8] ), y1 );
+        _mm512_storeu_pd( &y[k], y0 );
+        _mm512_storeu_pd( &y[k + 8], y1 );
+    }
+    for( ; k + 8 <= count; k += 8 ) {
+        __m512d y0 = _mm512_loadu_pd( &y[k] );
+        y0 = _mm512_fnmadd_pd( multiplier, _mm512_loadu_pd( &x[k] ), y0 );
+        _mm512_storeu_pd( &y[k], y0 );
+    }
+
+    // The last few elements are done with a masked operation rather than a scalar loop.
+    if( k < count ) {
+        __mmask8 mask = (__mmask8)( ( 1u << ( count - k ) ) - 1 );
+        __m512d y0 = _mm512_maskz_loadu_pd( mask, &y[k] );
+        y0 = _mm512_fnmadd_pd( multiplier, _mm512_maskz_loadu_pd( mask, &x[k] ), y0 );
+        _mm512_mask_storeu_pd( &y[k], mask, y0 );
+    }
+}
+
+__attribute__(( target( "avx512f" ) ))
+PRIVATE void row_axpy_float_avx512( size_t count, float m, const float * restrict x, float * restrict y )
+{
+    const __m512 multiplier = _mm512_set1_ps( m );
+    size_t k = 0;
+
+    for( ; k + 32 <= count; k += 32 ) {
+        __m512 y0 = _mm512_loadu_ps( &y[k] );
+        __m512 y1 = _mm512_loadu_ps( &y[k + 16] );
+        y0 = _mm512_fnmadd_ps( multiplier, _mm512_loadu_ps( &x[k] ), y0 );
+        y1 = _mm512_fnmadd_ps( multiplier, _mm512_loadu_ps( &x[k + 16] ), y1 );
+        _mm512_storeu_ps( &y[k], y0 );
+        _mm512_storeu_ps( &y[k + 16], y1 );
+    }
+    for( ; k + 16 <= count; k += 16 ) {
+        __m512 y0 = _mm512_loadu_ps( &y[k] );
+        y0 = _mm512_fnmadd_ps( multiplier, _mm512_loadu_ps( &x[k] ), y0 );
+        _mm512_storeu_ps( &y[k], y0 );
+    }
+    if( k < count ) {
+        __mmask16 mask = (__mmask16)( ( 1u << ( count - k ) ) - 1 );
+        __m512 y0 = _mm512_maskz_loadu_ps( mask, &y[k] );
+        y0 = _mm512_fnmadd_ps( multiplier, _mm512_maskz_loadu_ps( mask, &x[k] ), y0 );
+        _mm512_mask_storeu_ps( &y[k], mask, y0 );
+    }
+}
+
+//! Searches eight rows at a time. The elements are gathered straight from the row pointers.
+__attribute__(( target( "avx512f" ) ))
+PRIVATE size_t row_pivot_search_avx512( floating_type *const *rows, size_t column, size_t start, size_t stop )
+{
+    const __m512i offset = _mm512_set1_epi64( (long long)( column * sizeof( floating_type ) ) );
+    const __m512i step = _mm512_set1_epi64( 8 );
+    __m512d best_value = _mm512_set1_pd( -1.0 );
+    __m512i best_row = _mm512_set1_epi64( -1 );
+    __m512i row = _mm512_add_epi64( _mm512_set1_epi64( start ), _mm512_setr_epi64( 0, 1, 2, 3, 4, 5, 6, 7 ) );
+    size_t j = start;
+
+    while( j < stop ) {
+        // The last trip loads only the rows that remain.
+        __mmask8 live = ( stop - j >= 8 ) ? 0xFF : (__mmask8)( ( 1u << ( stop - j ) ) - 1 );
+        __m512i address = _mm512_add_epi64( _mm512_maskz_loadu_epi64( live, &rows[j] ), offset );
+        __m512d value = _mm512_abs_pd(
+            _mm512_mask_i64gather_pd( _mm512_set1_pd( -1.0 ), live, address, (const double *)0, 1 ) );
+        __mmask8 greater = _mm512_mask_cmp_pd_mask( live, value, best_value, _CMP_GT_OQ );
+        best_value = _mm512_mask_blend_pd( greater, best_value, value );
+        best_row = _mm512_mask_blend_epi64( greater, best_row, row );
+        row = _mm512_add_epi64( row, step );
+        j += 8;
+    }
+
+    // Ties go to the lowest row among the lanes holding the best value. If every element was a NaN
+    // no lane was ever updated; answer as the scalar version would.
+    double result_value = _mm512_reduce_max_pd( best_value );
+    if( result_value < 0.0 ) return start;
+    __mmask8 best = _mm512_cmp_pd_mask( best_value, _mm512_set1_pd( result_value ), _CMP_EQ_OQ );
+    return (size_t)_mm512_mask_reduce_min_epu64( best, best_row );
+}
+
+#endif
+
+
+PUBLIC void ( *row_axpy )( size_t count, floating_type m, const floating_type * restrict x, floating_type * restrict y ) = row_axpy_scalar;
+PUBLIC void ( *row_axpy_float )( size_t count, float m, const float * restrict x, float * restrict y ) = row_axpy_float_scalar;
+PUBLIC size_t ( *row_pivot_search )( floating_type *const *rows, size_t column, size_t start, size_t stop ) = row_pivot_search_scalar;
+
+static const char *kernels_name = "scalar";
+
+//! Selects the widest kernels the processor supports (or that GAUSSIAN_KERNELS allows).
+__attribute__(( constructor ))
+static void select_row_kernels( void )
+{
+    #ifdef ROW_KERNELS_X86
+    const char *requested = getenv( "GAUSSIAN_KERNELS" );
+    int allow_avx512 = ( requested == NULL || strcmp( requested, "avx512" ) == 0 );
+    int allow_avx2   = ( allow_avx512 || strcmp( requested, "avx2" ) == 0 );
+
+    __builtin_cpu_init( );
+    if( allow_avx512 && __builtin_cpu_supports( "avx512f" ) ) {
+        row_axpy = row_axpy_avx512;
+        row_axpy_float = row_axpy_float_avx512;
+        row_pivot_search = row_pivot_search_avx512;
+        kernels_name = "avx512";
+    }
+    else if( allow_avx2 && __builtin_cpu_supports( "avx2" ) && __builtin_cpu_supports( "fma" ) ) {
+        row_axpy = row_axpy_avx2;
+        row_axpy_float = row_axpy_float_avx2;
+        row_pivot_search = row_pivot_search_avx2;
+        kernels_name = "avx2";
+    }
+    #endif
+}
+
+
+PUBLIC const char *row_kernels_name( void )
+{
+    return kernels_name;
+}
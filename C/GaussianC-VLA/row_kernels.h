@@ -0,0 +1,33 @@
+/*!
+ * \file   row_kernels.h
+ * \brief  Interface to the vector kernels used in the inner loops of the elimination.
+ *
+ * The project is built for a baseline x86-64 processor, which leaves the compiler with SSE2. The
+ * kernels here are also written for AVX2 and AVX-512 (both with FMA) and the widest version the
+ * processor supports is selected when the program starts. Setting the environment variable
+ * GAUSSIAN_KERNELS to "scalar", "avx2", or "avx512" selects a narrower version instead.
+ */
+
+#ifndef ROW_KERNELS_H
+#define ROW_KERNELS_H
+
+#include <stddef.h>
+
+#include "gaussian.h"
+
+//! Computes y[k] -= m * x[k] for k = 0, ..., count - 1.
+extern void ( *row_axpy )( size_t count, floating_type m, const floating_type * restrict x, floating_type * restrict y );
+
+//! Computes y[k] -= m * x[k] for k = 0, ..., count - 1 in single precision.
+extern void ( *row_axpy_float )( size_t count, float m, const float * restrict x, float * restrict y );
+
+//! Returns the j in [start, stop) for which |rows[j][column]| is largest (the first, on ties).
+/*!
+ * The range must not be empty.
+ */
+extern size_t ( *row_pivot_search )( floating_type *const *rows, size_t column, size_t start, size_t stop );
+
+//! Returns the name of the selected kernels: "scalar", "avx2", or "avx512".
+const char *row_kernels_name( void );
+
+#endif
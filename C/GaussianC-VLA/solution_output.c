@@ -0,0 +1,230 @@
+/*!
+ * \file   solution_output.c
+ * \brief  Buffered text and binary writer for solutions.
+ *
+ * A double is m * 2^e with a 53 bit integer m. To print it with 17 significant digits the
+ * formatter needs round( m * 2^e * 10^q ) for the q that leaves 17 digits before the point.
+ * Writing 10^q as 5^q * 2^q, that is m * 5^q shifted left or right, or (for negative q) m shifted
+ * and divided by 5^-q. While 5^|q| fits in 64 bits the whole calculation fits in 128 bits and
+ * is exact, so the digits and their rounding agree with printf.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "solution_output.h"
+
+// For profiling, it is best for all functions to be public.
+#define PRIVATE // static
+#define PUBLIC
+
+// Size of the output buffer.
+#ifndef SOLUTION_BUFFER_SIZE
+#define SOLUTION_BUFFER_SIZE ( 1 << 20 )
+#endif
+
+// The largest |q| for which 5^|q| fits in 64 bits.
+#define SOLUTION_MAX_POWER 27
+
+typedef unsigned __int128 uint128;
+
+static const uint64_t powers_of_five[SOLUTION_MAX_POWER + 1] = {
+    1u, 5u, 25u, 125u, 625u, 3125u, 15625u, 78125u, 390625u, 1953125u, 9765625u, 48828125u,
+    244140625u, 1220703125u, 6103515625u, 30517578125u, 152587890625u, 762939453125u,
+    3814697265625u, 19073486328125u, 95367431640625u, 476837158203125u, 2384185791015625u,
+    11920928955078125u, 59604644775390625u, 298023223876953125u, 1490116119384765625u,
+    7450580596923828125u
+};
+
+#define TEN_TO_16 10000000000000000u
+#define TEN_TO_17 100000000000000000u
+
+//! Returns n / 2^shift rounded to nearest, ties to even.
+static inline uint128 shift_round( uint128 n, int shift )
+{
+    if( shift == 0 ) return n;
+    uint128 quotient = n >> shift;
+    uint128 remainder = n & ( ( (uint128)1 << shift ) - 1 );
+    uint128 half = (uint128)1 << ( shift - 1 );
+    if( remainder > half || ( remainder == half && ( quotient & 1 ) ) ) ++quotient;
+    return quotient;
+}
+
+//! Returns n / d rounded to nearest, ties to even.
+static inline uint128 divide_round( uint128 n, uint64_t d )
+{
+    uint128 quotient = n / d;
+    uint128 twice_remainder = ( n % d ) * 2;
+    if( twice_remainder > d || ( twice_remainder == d && ( quotient & 1 ) ) ) ++quotient;
+    return quotient;
+}
+
+
+PUBLIC size_t solution_format_double( double value, char *buffer )
+{
+    uint64_t bits;
+    uint64_t digits = 0;
+    char    *p = buffer;
+    int      k, attempt;
+
+    memcpy( &bits, &value, sizeof( bits ) );
+    int biased = (int)( ( bits >> 52 ) & 0x7FF );
+
+    // Zeros, subnormals, infinities, and NaNs are left to snprintf.
+    if( biased == 0 || biased == 0x7FF ) goto fallback;
+
+    uint64_t mantissa = ( bits & ( ( (uint64_t)1 << 52 ) - 1 ) ) | ( (uint64_t)1 << 52 );
+    int      exponent = biased - 1075;          // value = mantissa * 2^exponent
+    int      top = biased - 1023;               // 2^top <= |value| < 2^(top + 1)
+
+    // k = floor( log10 |value| ) is floor( top * log10( 2 ) ) or one more. 78913 / 2^18 is
+    // log10( 2 ) closely enough for every exponent a double can have.
+    k = ( top * 78913 ) >> 18;
+    for( attempt = 0; attempt < 2; ++attempt ) {
+        int q = 16 - k;
+        uint128 scaled;
+
+        if( q > SOLUTION_MAX_POWER || q < -SOLUTION_MAX_POWER ) goto fallback;
+        if( q >= 0 ) {
+            scaled = (uint128)mantissa * powers_of_five[q];
+            int shift = q + exponent;
+            scaled = ( shift >= 0 ) ? scaled << shift : shift_round( scaled, -shift );
+        }
+        else {
+            // Here |value| >= 1e17, so exponent + q is positive and the shift can't overflow.
+            scaled = divide_round( (uint128)mantissa << ( exponent + q ), powers_of_five[-q] );
+        }
+        if( scaled >= TEN_TO_17 ) {
+            ++k;
+            continue;
+        }
+        digits = (uint64_t)scaled;
+        break;
+    }
+    if( digits < TEN_TO_16 || digits >= TEN_TO_17 ) goto fallback;
+
+    // d.dddddddddddddddde+kk
+    if( bits >> 63 ) *p++ = '-';
+    char text[17];
+    for( int i = 16; i >= 0; --i ) {
+        text[i] = (char)( '0' + digits % 10 );
+        digits /= 10;
+    }
+    *p++ = text[0];
+    *p++ = '.';
+    memcpy( p, &text[1], 16 );
+    p += 16;
+    *p++ = 'e';
+    *p++ = ( k < 0 ) ? '-' : '+';
+    if( k < 0 ) k = -k;
+    if( k >= 100 ) *p++ = (char)( '0' + k / 100 );
+    *p++ = (char)( '0' + k / 10 % 10 );
+    *p++ = (char)( '0' + k % 10 );
+    return (size_t)( p - buffer );
+
+fallback:
+    return (size_t)snprintf( buffer, 32, "%.16e", value );
+}
+
+
+// The output buffer.
+typedef struct {
+    FILE  *file;
+    size_t used;
+    int    failed;
+    char  *data;
+} SolutionBuffer;
+
+//! Writes out the buffered characters.
+PRIVATE void buffer_flush( SolutionBuffer *buffer )
+{
+    if( buffer->used > 0 && fwrite( buffer->data, 1, buffer->used, buffer->file ) != buffer->used ) {
+        buffer->failed = 1;
+    }
+    buffer->used = 0;
+}
+
+//! Returns space for at least 'count' characters at the end of the buffer.
+static inline char *buffer_reserve( SolutionBuffer *buffer, size_t count )
+{
+    if( SOLUTION_BUFFER_SIZE - buffer->used < count ) buffer_flush( buffer );
+    return &buffer->data[buffer->used];
+}
+
+//! Writes 'value' right-aligned in at least 'width' characters, as printf's "%*zu" would.
+static inline char *format_index( char *p, size_t value, int width )
+{
+    char   digits[24];
+    int    count = 0;
+
+    do {
+        digits[count++] = (char)( '0' + value % 10 );
+        value /= 10;
+    } while( value != 0 );
+    for( int i = count; i < width; ++i ) *p++ = ' ';
+    while( count > 0 ) *p++ = digits[--count];
+    return p;
+}
+
+//! Formats element 'index' of x, which has the given precision.
+PRIVATE size_t format_element( enum GaussianPrecision precision, const void *x, size_t index, char *p )
+{
+    switch( precision ) {
+    case precision_float:
+        return solution_format_double( ( (const float *)x )[index], p );
+    case precision_double:
+        return solution_format_double( ( (const double *)x )[index], p );
+    case precision_long_double:
+        return (size_t)snprintf( p, 48, "%.20Le", ( (const long double *)x )[index] );
+    #ifdef GAUSSIAN_HAVE_FLOAT128
+    // Without libquadmath a __float128 can only be printed through long double.
+    case precision_float128:
+        return (size_t)snprintf( p, 48, "%.20Le", (long double)( (const __float128 *)x )[index] );
+    #endif
+    default:
+        return 0;
+    }
+}
+
+
+PUBLIC int solution_write( FILE *file, enum SolutionFormat format, enum GaussianPrecision precision, size_t size, size_t rhs_count, const void *x )
+{
+    if( format == solution_binary ) {
+        size_t count = size * rhs_count;
+        return fwrite( x, gaussian_precision_size( precision ), count, file ) == count && fflush( file ) == 0;
+    }
+
+    SolutionBuffer buffer = { file, 0, 0, (char *)malloc( SOLUTION_BUFFER_SIZE ) };
+    if( buffer.data == NULL ) return 0;
+    for( size_t i = 0; i < size; ++i ) {
+        for( size_t j = 0; j < rhs_count; ++j ) {
+            // The longest line is well under 128 characters.
+            char *p = buffer_reserve( &buffer, 128 );
+            char *start = p;
+            memcpy( p, " x[", 3 );
+            p = format_index( p + 3, i, 4 );
+            if( rhs_count != 1 ) {
+                memcpy( p, "][", 2 );
+                p = format_index( p + 2, j, 3 );
+            }
+            memcpy( p, "] = ", 4 );
+            p += 4;
+
+            // Non-negative values get a space where the sign would be, so the columns line up.
+            size_t length = format_element( precision, x, i * rhs_count + j, p + 1 );
+            if( p[1] == '-' ) {
+                memmove( p, p + 1, length );
+                p += length;
+            }
+            else {
+                *p = ' ';
+                p += length + 1;
+            }
+            *p++ = '\n';
+            buffer.used += (size_t)( p - start );
+        }
+    }
+    buffer_flush( &buffer );
+    free( buffer.data );
+    return !buffer.failed && fflush( file ) == 0;
+}
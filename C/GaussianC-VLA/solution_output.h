@@ -0,0 +1,39 @@
+/*!
+ * \file   solution_output.h
+ * \brief  Interface to the writer for solutions.
+ *
+ * Solutions are written through a large buffer. As text, each element is written with 17
+ * significant digits, which is enough to read back the same double. In binary, the solution
+ * matrix is written as it is held in memory: size x rhs_count elements of the solving precision
+ * in row-major order, with no header.
+ */
+
+#ifndef SOLUTION_OUTPUT_H
+#define SOLUTION_OUTPUT_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "gaussian.h"
+
+enum SolutionFormat {
+    solution_text,
+    solution_binary
+};
+
+//! Writes the solution x (size x rhs_count, row-major) to 'file'. Returns nonzero on success.
+/*!
+ * As text there is one line per element, " x[i] = value" for a single driving vector and
+ * " x[i][j] = value" otherwise. Non-negative values are preceded by a space.
+ */
+int solution_write( FILE *file, enum SolutionFormat format, enum GaussianPrecision precision, size_t size, size_t rhs_count, const void *x );
+
+//! Formats 'value' as printf's "%.16e" would and returns the number of characters written.
+/*!
+ * The buffer must have room for 32 characters; no terminating null is written. The digits are
+ * worked out exactly with integer arithmetic for magnitudes from about 1e-11 to 1e44, which
+ * covers nearly every solution. Other values go to snprintf.
+ */
+size_t solution_format_double( double value, char *buffer );
+
+#endif
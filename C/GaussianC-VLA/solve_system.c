@@ -6,9 +6,17 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <errno.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "gaussian.h"
+#include "gsys.h"
+#include "huge_pages.h"
+#include "phase_timing.h"
+#include "solution_output.h"
+#include "text_system.h"
 #include "Timer.h"
 
 int menu() {
@@ -17,49 +25,258 @@ int menu() {
     printf("2. Naive p_thread:\n");
     printf("3. Barrier p_thread:\n");
     printf("4. Thread Pool:\n");
+    printf("5. Blocked:\n");
+    printf("6. Recursive:\n");
+    printf("7. Mixed Precision:\n");
+    printf("8. Tiled:\n");
     return getchar();
 }
 
 
+//! Converts the name of a precision. Returns nonzero if the name is known.
+int parse_precision( const char *name, enum GaussianPrecision *precision )
+{
+    static const struct {
+        const char            *name;
+        enum GaussianPrecision precision;
+    } names[] = {
+        { "float",       precision_float },
+        { "double",      precision_double },
+        { "long-double", precision_long_double },
+        { "float128",    precision_float128 },
+    };
+
+    for( size_t i = 0; i < sizeof( names ) / sizeof( names[0] ); ++i ) {
+        if( strcmp( name, names[i].name ) == 0 ) {
+            *precision = names[i].precision;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+//! Releases a system loaded by main, whether it was mapped or read as text.
+/*!
+ * A matrix of a_bytes bytes that is not the one in the mapping is on huge pages, either as read
+ * from text or as copied out of the mapping.
+ */
+void release_system( GsysFile *mapped, void *a, void *b, size_t a_bytes )
+{
+    if( a != mapped->a ) {
+        huge_pages_free( a, a_bytes );
+    }
+    if( mapped->mapping != NULL ) {
+        gsys_unmap( mapped );
+    }
+    else {
+        free( b );
+    }
+}
+
+
+//! Returns the time in seconds on a clock that only goes forward.
+double sweep_clock( void )
+{
+    struct timespec now;
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return now.tv_sec + now.tv_nsec * 1.0E-9;
+}
+
+
+//! Solves the system with 1, 2, ... max_threads threads and reports how well the solver scales.
+/*!
+ * Each thread count gets the best of three solves, each on a fresh copy of the system so the
+ * original a and b are left as they are. The copy of a is on huge pages, with the same leading
+ * dimension as a, or, if 'numa' is set, placed for the number of threads solving it and padded
+ * as gaussian_leading_dimension says. Returns the result of the last solve.
+ */
+enum GaussianResult sweep(
+    enum GaussianPrecision precision, size_t size, size_t lda, size_t rhs_count, const void *a, const void *b,
+    int selection, int max_threads, int numa )
+{
+    size_t element_size = gaussian_precision_size( precision );
+    size_t a_bytes = size * lda * element_size;
+    size_t placed_lda = gaussian_leading_dimension( size, element_size );
+    size_t page_size;
+    void  *work_a = huge_pages_allocate( a_bytes, &page_size );
+    void  *work_b = malloc( size * rhs_count * element_size );
+    double single_threaded_time = 0.0;
+    enum GaussianResult result = gaussian_error;
+
+    if( work_a == NULL || work_b == NULL ) {
+        printf( "Error: Not enough memory for the sweep.\n" );
+        huge_pages_free( work_a, a_bytes );
+        free( work_b );
+        return gaussian_error;
+    }
+    if( !numa ) printf( "Matrix page size = %zu KB\n", page_size / 1024 );
+
+    gaussian_set_placement( numa );
+    for( int thread_count = 1; thread_count <= max_threads; ++thread_count ) {
+        double best_time = 0.0;
+        for( int run = 0; run < 3; ++run ) {
+            void *placed = NULL;
+            if( numa ) placed = gaussian_allocate_placed( size, placed_lda, element_size, thread_count, a, lda );
+            if( placed == NULL ) memcpy( work_a, a, a_bytes );
+            memcpy( work_b, b, size * rhs_count * element_size );
+
+            double start = sweep_clock( );
+            result = ( placed != NULL )
+                ? gaussian_solve_precision( precision, size, placed_lda, rhs_count, placed, work_b, selection, thread_count )
+                : gaussian_solve_precision( precision, size, lda, rhs_count, work_a, work_b, selection, thread_count );
+            double time = sweep_clock( ) - start;
+
+            gaussian_free_placed( placed, size, placed_lda, element_size );
+            if( result != gaussian_success ) break;
+            if( run == 0 || time < best_time ) best_time = time;
+        }
+        if( result != gaussian_success ) break;
+
+        if( thread_count == 1 ) single_threaded_time = best_time;
+        double speedup = single_threaded_time / best_time;
+        printf( "Size: %zu  Threads: %d  Time: %.3lf ms  Speedup: %.3lf  Efficiency: %.3lf\n",
+                size, thread_count, best_time * 1000.0, speedup, speedup / thread_count );
+        fflush( stdout );
+    }
+
+    huge_pages_free( work_a, a_bytes );
+    free( work_b );
+    return result;
+}
+
+
 int main( int argc, char *argv[] )
 {
-    FILE   *input_file;
     size_t  size;
+    size_t  lda;
+    size_t  rhs_count;
+    void   *a;
+    void   *b;
+    GsysFile mapped = { 0 };
+    enum GaussianPrecision precision = precision_double;
+    int     precision_given = 0;
+    const char *convert_path = NULL;
+    const char *output_path = NULL;
+    enum SolutionFormat output_format = solution_text;
+    int     show_phases = 0;
+    int     numa = 0;
+    int     thread_count = 0;
+    int     sweep_threads = 0;
+    size_t  page_size = 0;
+
+    // Take the options out of the argument list, leaving the positional arguments behind.
+    int positional = 1;
+    for( int i = 1; i < argc; ++i ) {
+        const char *name = NULL;
+        if( strncmp( argv[i], "--precision=", 12 ) == 0 ) {
+            name = argv[i] + 12;
+        }
+        else if( strcmp( argv[i], "-p" ) == 0 && i + 1 < argc ) {
+            name = argv[++i];
+        }
+        else if( strncmp( argv[i], "--convert=", 10 ) == 0 ) {
+            convert_path = argv[i] + 10;
+            continue;
+        }
+        else if( strncmp( argv[i], "--output=", 9 ) == 0 ) {
+            output_path = argv[i] + 9;
+            continue;
+        }
+        else if( strcmp( argv[i], "--binary" ) == 0 ) {
+            output_format = solution_binary;
+            continue;
+        }
+        else if( strcmp( argv[i], "--phases" ) == 0 ) {
+            show_phases = 1;
+            continue;
+        }
+        else if( strcmp( argv[i], "--numa" ) == 0 ) {
+            numa = 1;
+            continue;
+        }
+        else if( strncmp( argv[i], "--threads=", 10 ) == 0 || ( strcmp( argv[i], "-t" ) == 0 && i + 1 < argc ) ) {
+            const char *count = ( argv[i][1] == 't' ) ? argv[++i] : argv[i] + 10;
+            char *end;
+            errno = 0;
+            long converted = strtol( count, &end, 10 );
+            if( errno != 0 || *end != '\0' || converted <= 0 || converted > 4096 ) {
+                printf( "Error: The thread count '%s' is not a positive number.\n", count );
+                return EXIT_FAILURE;
+            }
+            thread_count = (int)converted;
+            continue;
+        }
+        else if( strcmp( argv[i], "--sweep" ) == 0 ) {
+            sweep_threads = 1;
+            continue;
+        }
+        else {
+            argv[positional++] = argv[i];
+            continue;
+        }
+        if( !parse_precision( name, &precision ) || gaussian_precision_size( precision ) == 0 ) {
+            printf( "Error: Unknown or unsupported precision '%s'. Use float, double, long-double, or float128.\n", name );
+            return EXIT_FAILURE;
+        }
+        precision_given = 1;
+    }
+    argc = positional;
 
     if( argc < 2 ) {
         printf( "Error: Expected the name of a system definition file.\n" );
         return EXIT_FAILURE;
     }
-
-    // Open the file.
-    if( (input_file = fopen( argv[1], "r" )) == NULL ) {
-        printf("Error: Can not open the system definition file.\n");
+    if( output_format == solution_binary && output_path == NULL ) {
+        printf( "Error: Binary output needs a file named with --output=PATH.\n" );
         return EXIT_FAILURE;
     }
 
-    // Get the size.
-    fscanf( input_file, "%zu", &size );
-
-    // Allocate the arrays on the stack... except this overflows the stack for large systems.
-    //floating_type a[size][size];
-    //floating_type b[size];
+    // Load the system. A .gsys file is mapped into memory as it stands; anything else is read
+    // as text in the selected precision.
+    if( gsys_is_gsys( argv[1] ) ) {
+        enum GsysResult load_result = gsys_map( argv[1], 1, &mapped );
+        if( load_result != gsys_success ) {
+            printf( "Error: Can not load %s: %s.\n", argv[1], gsys_result_text( load_result ) );
+            return EXIT_FAILURE;
+        }
+        if( precision_given && precision != mapped.precision ) {
+            printf( "Error: The system in %s has a different precision.\n", argv[1] );
+            gsys_unmap( &mapped );
+            return EXIT_FAILURE;
+        }
+        precision = mapped.precision;
+        size = mapped.size;
+        lda = mapped.size;
+        rhs_count = mapped.rhs_count;
+        a = mapped.a;
+        b = mapped.b;
+        page_size = (size_t)sysconf( _SC_PAGESIZE );
+    }
+    else {
+        enum TextSystemResult read_result = text_system_read( argv[1], precision, &size, &lda, &rhs_count, &a, &b, &page_size );
+        if( read_result != text_success ) {
+            printf( "Error: Can not read %s: %s.\n", argv[1], text_system_result_text( read_result ) );
+            return EXIT_FAILURE;
+        }
+    }
 
-    // Allocate the arrays dynamically.
-    typedef floating_type row_t[size];
-    row_t *a = (row_t *)malloc( size * size * sizeof( floating_type ) );
-    floating_type *b = (floating_type *)malloc( size * sizeof( floating_type ) );
+    size_t element_size = gaussian_precision_size( precision );
+    size_t a_bytes = size * lda * element_size;
 
-    // Get coefficients.
-    // Note that the format specifier used here, `%lf`, assumes the matrix elements have type
-    // double. See the declaration of `floating_type` at the top of gaussian.h.
-    //
-    for( size_t i = 0; i < size; ++i ) {
-        for( size_t j = 0; j < size; ++j ) {
-            fscanf( input_file, "%lf", &a[i][j] );
+    // Convert the system instead of solving it, if asked. A .gsys file holds the rows without
+    // padding, so they are first moved together, in place.
+    if( convert_path != NULL ) {
+        for( size_t i = 1; i < size && lda != size; ++i ) {
+            memmove( (char *)a + i * size * element_size, (char *)a + i * lda * element_size, size * element_size );
+        }
+        enum GsysResult write_result = gsys_write( convert_path, precision, size, rhs_count, a, b, 1 );
+        if( write_result != gsys_success ) {
+            printf( "Error: Can not write %s: %s.\n", convert_path, gsys_result_text( write_result ) );
         }
-        fscanf( input_file, "%lf", &b[i] );
+        release_system( &mapped, a, b, a_bytes );
+        return write_result == gsys_success ? EXIT_SUCCESS : EXIT_FAILURE;
     }
-    fclose( input_file );
 
     // printf( "\nFinished reading %s\n", argv[1] );
 
@@ -76,22 +293,106 @@ int main( int argc, char *argv[] )
     if (selection == 0) {
         selection = menu();
     }
+    if( !gaussian_precision_has_strategy( precision, selection ) ) {
+        printf( "Error: Outside double precision only the serial (1), p_thread (2), and blocked (5)\n"
+                "strategies are available.\n" );
+        release_system( &mapped, a, b, a_bytes );
+        return EXIT_FAILURE;
+    }
+
+    // Only the barrier and thread pool strategies keep their threads on the rows that were placed
+    // for them. Any other would solve a placed matrix that no thread owns.
+    if( numa && selection != 3 && selection != '3' && selection != 4 && selection != '4' ) {
+        printf( "Warning: --numa only applies to the barrier (3) and thread pool (4) strategies. Ignoring it.\n" );
+        numa = 0;
+    }
+
+    // A mapped matrix is unpadded and on the small pages of the file. Solve a padded copy on huge
+    // pages instead; the copy costs about as much as the copy-on-write faults of solving the
+    // matrix in place would. With --numa the placed copy is padded from the mapping directly.
+    if( mapped.mapping != NULL && !numa ) {
+        size_t copy_lda = gaussian_leading_dimension( size, element_size );
+        void  *copy = huge_pages_allocate( size * copy_lda * element_size, &page_size );
+        if( copy != NULL ) {
+            for( size_t i = 0; i < size; ++i ) {
+                memcpy( (char *)copy + i * copy_lda * element_size, (char *)a + i * lda * element_size, size * element_size );
+            }
+            a = copy;
+            lda = copy_lda;
+            a_bytes = size * lda * element_size;
+        }
+    }
 
-    // Do the calculations.
+    // Measure the scaling instead of solving once, if asked. The sweep goes up to the requested
+    // number of threads, or to the number of processors if none was requested.
+    if( sweep_threads ) {
+        enum GaussianResult result = sweep(
+            precision, size, lda, rhs_count, a, b, selection, gaussian_thread_count( thread_count ), numa );
+        if( result == gaussian_degenerate ) {
+            printf( "System is degenerate. It does not have a unique solution.\n" );
+        }
+        release_system( &mapped, a, b, a_bytes );
+        return result == gaussian_success ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // For a NUMA machine, move the matrix into memory placed for the threads that will own its
+    // rows. The placed copy is solved; the original is only released at the end.
+    void  *placed = NULL;
+    size_t placed_lda = gaussian_leading_dimension( size, element_size );
+    if( numa ) {
+        gaussian_set_placement( 1 );
+        placed = gaussian_allocate_placed( size, placed_lda, element_size, thread_count, a, lda );
+        if( placed == NULL ) {
+            printf( "Warning: Can not place the matrix. Solving it where it is.\n" );
+        }
+        else {
+            // Rows are placed one by one, so the placed copy stays on small pages.
+            page_size = (size_t)sysconf( _SC_PAGESIZE );
+        }
+    }
+
+    // Do the calculations, timing each phase if asked.
+    static GaussianProfile profile;
+    if( show_phases ) gaussian_profile_begin( &profile );
     Timer stopwatch;
     Timer_initialize( &stopwatch );
     Timer_start( &stopwatch );
-    enum GaussianResult result = gaussian_solve( size, a, b, selection );
+    enum GaussianResult result = ( placed != NULL )
+        ? gaussian_solve_precision( precision, size, placed_lda, rhs_count, placed, b, selection, thread_count )
+        : gaussian_solve_precision( precision, size, lda, rhs_count, a, b, selection, thread_count );
     Timer_stop( &stopwatch );
+    if( show_phases ) gaussian_profile_end( );
 
     // Display the results.
+    int exit_status = EXIT_SUCCESS;
     switch( result ) {
     case gaussian_success:
-        printf( "\nSolution is\n" );
-        for( size_t i = 0; i < size; ++i ) {
-            printf( " x[%4zu] = %9.5f\n", i, b[i] );
+        if( output_path == NULL ) {
+            printf( "\nSolution is\n" );
+            fflush( stdout );
+            if( !solution_write( stdout, solution_text, precision, size, rhs_count, b ) ) {
+                fprintf( stderr, "Error: Can not write the solution.\n" );
+                exit_status = EXIT_FAILURE;
+            }
+        }
+        else {
+            // The end of the solution is only written when the file is closed, so a failed close
+            // is a failed write.
+            FILE *output_file = fopen( output_path, output_format == solution_binary ? "wb" : "w" );
+            int written = output_file != NULL &&
+                          solution_write( output_file, output_format, precision, size, rhs_count, b );
+            if( output_file != NULL && fclose( output_file ) != 0 ) written = 0;
+            if( !written ) {
+                printf( "Error: Can not write the solution to %s.\n", output_path );
+                exit_status = EXIT_FAILURE;
+            }
+            else {
+                printf( "\nSolution written to %s\n", output_path );
+            }
         }
         printf( "Execution time = %ld milliseconds\n", Timer_time( &stopwatch ) );
+        printf( "Matrix page size = %zu KB\n", page_size / 1024 );
+        if( show_phases ) gaussian_profile_report( &profile, stdout );
         break;
 
     case gaussian_error:
@@ -103,8 +404,8 @@ int main( int argc, char *argv[] )
         break;
     }
 
-    // Clean up the dynamically allocated space.
-    free( a );
-    free( b );
-    return EXIT_SUCCESS;
+    // Clean up the dynamically allocated (or mapped) space.
+    gaussian_free_placed( placed, size, placed_lda, element_size );
+    release_system( &mapped, a, b, a_bytes );
+    return exit_status;
 }
@@ -0,0 +1,461 @@
+/*!
+ * \file   text_system.c
+ * \brief  Parallel reader for text system files.
+ *
+ * Reading is done in two rounds of a WorkerTeam. In the first each thread counts the numbers in
+ * its part of the file. The counts say where each part's first number belongs, so in the second
+ * round every thread can parse its part and store each number directly where it goes.
+ *
+ * The fast conversion is Clinger's: a decimal with at most 19 significant digits is an exact
+ * integer m times a power of ten, and when both fit exactly in a floating type one operation
+ * rounds the result correctly. Doubles hold powers of ten up to 1e22 exactly and m up to 2^53.
+ * For longer mantissas (17 digit values are common) the operation is done in the 64 bit mantissa
+ * of long double where there is one, which is correctly rounded to double unless the long double
+ * lands right next to a point halfway between two doubles. Those cases, and anything else
+ * unusual, go to strtod.
+ */
+
+#include <float.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__GLIBC__) || defined(__CYGWIN__)
+#include <sys/sysinfo.h>  // For get_nprocs( ).
+#endif
+
+#include "WorkerTeam.h"
+#include "huge_pages.h"
+#include "text_system.h"
+
+// For profiling, it is best for all functions to be public.
+#define PRIVATE // static
+#define PUBLIC
+
+// Files are divided so each thread gets at least this many bytes.
+#ifndef TEXT_CHUNK_SIZE
+#define TEXT_CHUNK_SIZE ( 1L << 20 )
+#endif
+
+// The longest number handed to strtod.
+#define TEXT_TOKEN_MAX 512
+
+#if LDBL_MANT_DIG >= 64
+#define TEXT_LONG_DOUBLE_PATH
+#endif
+
+static const double exact_powers[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+#ifdef TEXT_LONG_DOUBLE_PATH
+static const long double exact_long_powers[] = {
+    1e0L,  1e1L,  1e2L,  1e3L,  1e4L,  1e5L,  1e6L,  1e7L,  1e8L,  1e9L,
+    1e10L, 1e11L, 1e12L, 1e13L, 1e14L, 1e15L, 1e16L, 1e17L, 1e18L, 1e19L,
+    1e20L, 1e21L, 1e22L, 1e23L, 1e24L, 1e25L, 1e26L, 1e27L
+};
+#endif
+
+static inline int is_space( char c )
+{
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+static inline int is_digit( char c )
+{
+    return (unsigned)( c - '0' ) < 10u;
+}
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define TEXT_EIGHT_DIGITS
+//! Returns nonzero if the eight characters in 'chunk' are all digits.
+static inline int is_eight_digits( uint64_t chunk )
+{
+    return ( ( chunk & 0xF0F0F0F0F0F0F0F0u ) |
+             ( ( ( chunk + 0x0606060606060606u ) & 0xF0F0F0F0F0F0F0F0u ) >> 4 ) ) == 0x3333333333333333u;
+}
+
+//! Returns the value of the eight digits in 'chunk', the first in the lowest byte.
+static inline uint64_t eight_digits_value( uint64_t chunk )
+{
+    chunk -= 0x3030303030303030u;
+    chunk = ( chunk * 10 ) + ( chunk >> 8 );
+    return ( ( ( chunk & 0x000000FF000000FFu ) * 0x000F424000000064u ) +
+             ( ( ( chunk >> 16 ) & 0x000000FF000000FFu ) * 0x0000271000000001u ) ) >> 32;
+}
+#endif
+
+//! Appends the digits starting at *p to mantissa, eight at a time while it can.
+/*!
+ * Leading zeros are skipped. Returns the number of digits consumed, or -1 if there are more than
+ * 19 significant digits.
+ */
+static inline int parse_digits( const char **p, const char *end, uint64_t *mantissa, int *digits )
+{
+    const char *q = *p;
+
+    while( q < end && is_digit( *q ) ) {
+        #ifdef TEXT_EIGHT_DIGITS
+        uint64_t chunk;
+        if( *mantissa != 0 && *digits + 8 <= 19 && end - q >= 8 ) {
+            memcpy( &chunk, q, sizeof( chunk ) );
+            if( is_eight_digits( chunk ) ) {
+                *mantissa = *mantissa * 100000000u + eight_digits_value( chunk );
+                *digits += 8;
+                q += 8;
+                continue;
+            }
+        }
+        #endif
+        if( *mantissa != 0 || *q != '0' ) {
+            if( ++*digits > 19 ) return -1;
+            *mantissa = *mantissa * 10 + (uint64_t)( *q - '0' );
+        }
+        ++q;
+    }
+    int consumed = (int)( q - *p );
+    *p = q;
+    return consumed;
+}
+
+//! Converts [begin, end) with strtod (or strtold), which needs a terminated copy.
+PRIVATE int slow_parse( const char *begin, const char *end, int long_double, long double *value )
+{
+    char  token[TEXT_TOKEN_MAX + 1];
+    char *token_end;
+    size_t length = (size_t)( end - begin );
+
+    if( length > TEXT_TOKEN_MAX ) return 0;
+    memcpy( token, begin, length );
+    token[length] = '\0';
+    *value = long_double ? strtold( token, &token_end ) : strtod( token, &token_end );
+    return length > 0 && token_end == token + length;
+}
+
+#ifdef TEXT_LONG_DOUBLE_PATH
+//! Rounds mantissa * 10^exponent to double through long double, if that is sure to be correct.
+PRIVATE int long_double_parse( uint64_t mantissa, int exponent, double *value )
+{
+    long double exact = exponent >= 0 ? (long double)mantissa * exact_long_powers[exponent]
+                                      : (long double)mantissa / exact_long_powers[-exponent];
+    double   rounded = (double)exact;
+    uint64_t bits;
+    double   neighbour;
+
+    // The neighbour of 'rounded' on the side of 'exact'. Everything here is positive and normal.
+    long double remainder = exact - (long double)rounded;
+    memcpy( &bits, &rounded, sizeof( bits ) );
+    bits += ( remainder >= 0 ) ? 1 : -1;
+    memcpy( &neighbour, &bits, sizeof( neighbour ) );
+
+    // 'exact' is within half a long double ulp of the true value. If a point halfway between
+    // doubles could be between them, the answer isn't settled.
+    long double half_gap = ( (long double)neighbour - (long double)rounded ) / 2;
+    long double margin = ( half_gap < 0 ? -half_gap : half_gap ) - ( remainder < 0 ? -remainder : remainder );
+    if( margin <= exact * 0x1p-62L ) return 0;
+
+    *value = rounded;
+    return 1;
+}
+#endif
+
+PUBLIC int text_parse_double( const char *begin, const char *end, double *value )
+{
+    const char *p = begin;
+    uint64_t    mantissa = 0;
+    int         digits = 0;       // Significant digits in the mantissa.
+    int         exponent = 0;
+    int         any_digits = 0;
+    int         negative = 0;
+    long double slow_value;
+
+    if( p < end && ( *p == '-' || *p == '+' ) ) {
+        negative = ( *p == '-' );
+        ++p;
+    }
+    int consumed = parse_digits( &p, end, &mantissa, &digits );
+    if( consumed < 0 ) goto slow;
+    any_digits = ( consumed > 0 );
+    if( p < end && *p == '.' ) {
+        ++p;
+        consumed = parse_digits( &p, end, &mantissa, &digits );
+        if( consumed < 0 ) goto slow;
+        any_digits |= ( consumed > 0 );
+        exponent -= consumed;
+    }
+    if( !any_digits ) goto slow;
+    if( p < end && ( *p == 'e' || *p == 'E' ) ) {
+        int exponent_negative = 0;
+        int explicit_exponent = 0;
+        int exponent_digits = 0;
+
+        if( ++p < end && ( *p == '-' || *p == '+' ) ) {
+            exponent_negative = ( *p == '-' );
+            ++p;
+        }
+        for( ; p < end && is_digit( *p ); ++p ) {
+            if( ++exponent_digits > 5 ) goto slow;
+            explicit_exponent = explicit_exponent * 10 + ( *p - '0' );
+        }
+        if( exponent_digits == 0 ) goto slow;
+        exponent += exponent_negative ? -explicit_exponent : explicit_exponent;
+    }
+    if( p != end ) goto slow;
+
+    if( mantissa == 0 ) {
+        *value = negative ? -0.0 : 0.0;
+        return 1;
+    }
+    if( mantissa <= ( (uint64_t)1 << 53 ) && exponent >= -22 && exponent <= 22 ) {
+        double result = (double)mantissa;
+        result = exponent >= 0 ? result * exact_powers[exponent] : result / exact_powers[-exponent];
+        *value = negative ? -result : result;
+        return 1;
+    }
+    #ifdef TEXT_LONG_DOUBLE_PATH
+    if( exponent >= -27 && exponent <= 27 && long_double_parse( mantissa, exponent, value ) ) {
+        if( negative ) *value = -*value;
+        return 1;
+    }
+    #endif
+
+slow:
+    if( !slow_parse( begin, end, 0, &slow_value ) ) return 0;
+    *value = (double)slow_value;
+    return 1;
+}
+
+
+// Structure to define the part of the file handled by a single thread.
+struct TextWorkUnit {
+    const char *begin;          // The part is [begin, end). It starts and ends at white space.
+    const char *end;
+    size_t first;               // The index (in the whole system) of the part's first number.
+    size_t count;               // The number of numbers in the part.
+    size_t needed;              // The number of numbers in the whole system.
+    size_t size;
+    size_t lda;                 // The distance between the rows of a, in elements.
+    size_t rhs_count;
+    enum GaussianPrecision precision;
+    void  *a;
+    void  *b;
+    int    error;               // Nonzero if the part holds something that isn't a number.
+};
+
+//! Counts the numbers in one part of the file.
+PRIVATE void *text_count_work( void *arg )
+{
+    struct TextWorkUnit *unit = (struct TextWorkUnit *)arg;
+    const char *p = unit->begin;
+    size_t count = 0;
+
+    // Count the starts of numbers: characters that aren't white space after ones that are. The
+    // part starts just after white space. This has no branches, so it can be vectorized.
+    int previous_space = 1;
+    for( ; p < unit->end; ++p ) {
+        int space = is_space( *p );
+        count += previous_space & !space;
+        previous_space = space;
+    }
+    unit->count = count;
+    return NULL;
+}
+
+//! Parses the numbers in one part of the file into a and b.
+PRIVATE void *text_parse_work( void *arg )
+{
+    struct TextWorkUnit *unit = (struct TextWorkUnit *)arg;
+    const size_t width = unit->size + unit->rhs_count;
+    const char  *p = unit->begin;
+    size_t       index = unit->first;
+    size_t       row = index / width;
+    size_t       column = index % width;
+
+    while( p < unit->end && index < unit->needed ) {
+        while( p < unit->end && is_space( *p ) ) ++p;
+        if( p == unit->end ) break;
+        const char *token = p;
+        while( p < unit->end && !is_space( *p ) ) ++p;
+
+        // Find the element. Matrix elements come first in each row, then the driving vectors.
+        void  *array;
+        size_t offset;
+        if( column < unit->size ) {
+            array = unit->a;
+            offset = row * unit->lda + column;
+        }
+        else {
+            array = unit->b;
+            offset = row * unit->rhs_count + ( column - unit->size );
+        }
+
+        double      value;
+        long double long_value;
+        int         ok;
+        switch( unit->precision ) {
+        case precision_float:
+            // Rounding twice could differ from strtof in the last place, but only for numbers
+            // that lie almost exactly halfway between two floats.
+            ok = text_parse_double( token, p, &value );
+            ( (float *)array )[offset] = (float)value;
+            break;
+        case precision_double:
+            ok = text_parse_double( token, p, &( (double *)array )[offset] );
+            break;
+        case precision_long_double:
+            ok = slow_parse( token, p, 1, &long_value );
+            ( (long double *)array )[offset] = long_value;
+            break;
+        #ifdef GAUSSIAN_HAVE_FLOAT128
+        // Without libquadmath there is no way to parse a __float128 directly.
+        case precision_float128:
+            ok = slow_parse( token, p, 1, &long_value );
+            ( (__float128 *)array )[offset] = long_value;
+            break;
+        #endif
+        default:
+            ok = 0;
+            break;
+        }
+        if( !ok ) {
+            unit->error = 1;
+            break;
+        }
+
+        ++index;
+        if( ++column == width ) {
+            column = 0;
+            ++row;
+        }
+    }
+    return NULL;
+}
+
+
+PUBLIC enum TextSystemResult text_system_read( const char *path, enum GaussianPrecision precision, size_t *size_out, size_t *lda_out, size_t *rhs_count_out, void **a_out, void **b_out, size_t *page_size )
+{
+    struct stat status;
+    size_t size;
+    size_t rhs_count = 1;
+    char   header[128];
+    int    descriptor;
+
+    size_t element_size = gaussian_precision_size( precision );
+    if( element_size == 0 ) return text_format_error;
+
+    if( ( descriptor = open( path, O_RDONLY ) ) < 0 ) return text_io_error;
+    if( fstat( descriptor, &status ) != 0 ) {
+        close( descriptor );
+        return text_io_error;
+    }
+    if( status.st_size == 0 ) {
+        close( descriptor );
+        return text_format_error;
+    }
+    size_t file_size = (size_t)status.st_size;
+    const char *text = (const char *)mmap( NULL, file_size, PROT_READ, MAP_PRIVATE, descriptor, 0 );
+    close( descriptor );
+    if( text == MAP_FAILED ) return text_io_error;
+    madvise( (void *)text, file_size, MADV_SEQUENTIAL );
+
+    // Get the size. It may be followed on the same line by the number of driving vectors.
+    const char *end = text + file_size;
+    const char *body = memchr( text, '\n', file_size );
+    body = ( body == NULL ) ? end : body + 1;
+    size_t header_length = (size_t)( body - text ) < sizeof( header ) ? (size_t)( body - text ) : sizeof( header ) - 1;
+    memcpy( header, text, header_length );
+    header[header_length] = '\0';
+    // The sizes come from the file, so the arrays they imply must be checked for overflow.
+    if( sscanf( header, "%zu %zu", &size, &rhs_count ) < 1 || size == 0 || rhs_count == 0 ||
+        size > SIZE_MAX / element_size / size || rhs_count > SIZE_MAX / element_size / size ) {
+        munmap( (void *)text, file_size );
+        return text_format_error;
+    }
+    size_t lda = gaussian_leading_dimension( size, element_size );
+    if( lda > SIZE_MAX / element_size / size ) {
+        munmap( (void *)text, file_size );
+        return text_format_error;
+    }
+
+    // Divide the rest of the file among the threads. Each part starts just after white space.
+    #if defined(__GLIBC__) || defined(__CYGWIN__)
+    int processor_count = get_nprocs( );
+    #else
+    int processor_count = pthread_num_processors_np( );
+    #endif
+    size_t body_size = (size_t)( end - body );
+    int thread_count = (int)( body_size / TEXT_CHUNK_SIZE ) + 1;
+    if( thread_count > processor_count ) thread_count = processor_count;
+
+    struct TextWorkUnit *units = (struct TextWorkUnit *)calloc( thread_count, sizeof( struct TextWorkUnit ) );
+    void *a = huge_pages_allocate( size * lda * element_size, page_size );
+    void *b = malloc( size * rhs_count * element_size );
+    if( units == NULL || a == NULL || b == NULL ) {
+        free( units );
+        huge_pages_free( a, size * lda * element_size );
+        free( b );
+        munmap( (void *)text, file_size );
+        return text_io_error;
+    }
+    for( int h = 0; h < thread_count; ++h ) {
+        const char *begin = body + body_size / thread_count * h;
+        while( h > 0 && begin < end && !is_space( begin[-1] ) ) ++begin;
+        units[h].begin = begin;
+        if( h > 0 ) units[h - 1].end = begin;
+        units[h].needed = size * ( size + rhs_count );
+        units[h].size = size;
+        units[h].lda = lda;
+        units[h].rhs_count = rhs_count;
+        units[h].precision = precision;
+        units[h].a = a;
+        units[h].b = b;
+    }
+    units[thread_count - 1].end = end;
+
+    WorkerTeam team;
+    WorkerTeam_initialize( &team, thread_count );
+    WorkerTeam_run( &team, text_count_work, units, sizeof( struct TextWorkUnit ) );
+    size_t total = 0;
+    for( int h = 0; h < thread_count; ++h ) {
+        units[h].first = total;
+        total += units[h].count;
+    }
+    enum TextSystemResult result = ( total < units[0].needed ) ? text_format_error : text_success;
+    if( result == text_success ) {
+        WorkerTeam_run( &team, text_parse_work, units, sizeof( struct TextWorkUnit ) );
+        for( int h = 0; h < thread_count; ++h ) {
+            if( units[h].error ) result = text_format_error;
+        }
+    }
+    WorkerTeam_destroy( &team );
+
+    free( units );
+    munmap( (void *)text, file_size );
+    if( result != text_success ) {
+        huge_pages_free( a, size * lda * element_size );
+        free( b );
+        return result;
+    }
+    *size_out = size;
+    *lda_out = lda;
+    *rhs_count_out = rhs_count;
+    *a_out = a;
+    *b_out = b;
+    return text_success;
+}
+
+
+PUBLIC const char *text_system_result_text( enum TextSystemResult result )
+{
+    switch( result ) {
+    case text_success:      return "success";
+    case text_io_error:     return "the file could not be opened or read, or there is no memory for it";
+    case text_format_error: return "the file is not a valid system definition";
+    default:                return "unknown error";
+    }
+}
@@ -0,0 +1,46 @@
+/*!
+ * \file   text_system.h
+ * \brief  Interface to the parallel reader for text system files.
+ *
+ * A text system file starts with a line holding the size and, optionally, the number of driving
+ * vectors. The numbers of the system follow, separated by white space: each row of the matrix
+ * and then the matching element of each driving vector. The reader maps the file, divides it
+ * among threads at white space, and parses the numbers with a locale-free parser. Each number
+ * is stored straight into its place in a or b.
+ */
+
+#ifndef TEXT_SYSTEM_H
+#define TEXT_SYSTEM_H
+
+#include <stddef.h>
+
+#include "gaussian.h"
+
+enum TextSystemResult {
+    text_success,
+    text_io_error,              // The file could not be opened or mapped, or there is no memory for the system.
+    text_format_error           // The header is missing, a number is malformed, or numbers are missing.
+};
+
+//! Reads a system from a text file into newly allocated arrays of the given precision.
+/*!
+ * On success *a and *b point at size x size and size x rhs_count matrices in row-major order.
+ * The rows of a are *lda elements apart, as chosen by gaussian_leading_dimension, and the padding
+ * is zero. The matrix a is on huge pages where possible; release its size * lda elements with
+ * huge_pages_free and b with free.
+ * The size of the pages backing a goes in *page_size if page_size is not NULL. Numbers after the
+ * last one needed are ignored.
+ */
+enum TextSystemResult text_system_read( const char *path, enum GaussianPrecision precision, size_t *size, size_t *lda, size_t *rhs_count, void **a, void **b, size_t *page_size );
+
+//! Parses the number in [begin, end) as a double. Returns nonzero if it is a valid number.
+/*!
+ * The result is correctly rounded, as from strtod in the C locale. Most numbers are converted
+ * without strtod, which is only called for the rare cases the fast conversion can't settle.
+ */
+int text_parse_double( const char *begin, const char *end, double *value );
+
+//! Returns a description of a result for error messages.
+const char *text_system_result_text( enum TextSystemResult result );
+
+#endif
@@ -0,0 +1,268 @@
+/*!
+ * \file   tiled.c
+ * \brief  The tile-major matrix layout and the LU factorization that works on it.
+ *
+ * The factorization is right looking, one tile column at a time. At step K the calling thread
+ * factors tile column K (the panel), exchanging rows within the panel only. The rest of the work
+ * of the step is divided among the team by tile column: for each other tile column J a thread
+ * makes the same row exchanges and, if J is to the right of the panel, solves the top tile
+ * against the panel's diagonal tile and subtracts the products of the panel's tiles from the
+ * tiles below it. Tile columns are independent, so that takes no more synchronization than the
+ * end of the round.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "WorkerTeam.h"
+#include "phase_timing.h"
+#include "row_kernels.h"
+#include "tiled.h"
+
+// For profiling, it is best for all functions to be public.
+#define PRIVATE // static
+#define PUBLIC
+
+// Structure to define the tile columns updated by a single thread in one step.
+struct TiledWorkUnit {
+    floating_type *tiles;
+    const size_t  *pivots;
+    size_t size;
+    size_t count;                // Tiles on a side.
+    size_t step;                 // The tile column of the panel.
+    int    member;               // This unit's place in the team; it takes every team_size'th column.
+    int    team_size;
+    GaussianProfile *profile;    // NULL unless the solve is being timed.
+    double update_time;          // Time taken by the last round.
+};
+
+
+PUBLIC size_t tiled_count( size_t size )
+{
+    return ( size + TILE_SIZE - 1 ) / TILE_SIZE;
+}
+
+
+PUBLIC void tiled_from_rows( size_t size, floating_type *const *rows, floating_type * restrict tiles )
+{
+    const size_t count = tiled_count( size );
+    const size_t padded = count * TILE_SIZE;
+    size_t       i, j, width;
+
+    for( i = 0; i < padded; ++i ) {
+        for( j = 0; j < padded; j += TILE_SIZE ) {
+            floating_type *segment = tiled_tile( tiles, count, i / TILE_SIZE, j / TILE_SIZE ) + ( i % TILE_SIZE ) * TILE_SIZE;
+            width = ( i >= size || j >= size ) ? 0 : ( size - j < TILE_SIZE ) ? size - j : TILE_SIZE;
+
+            if( width > 0 ) memcpy( segment, &rows[i][j], width * sizeof( floating_type ) );
+            memset( segment + width, 0, ( TILE_SIZE - width ) * sizeof( floating_type ) );
+            if( i >= size && i / TILE_SIZE == j / TILE_SIZE ) {
+                segment[i % TILE_SIZE] = 1.0;
+            }
+        }
+    }
+}
+
+
+PUBLIC void tiled_to_rows( size_t size, const floating_type * restrict tiles, floating_type *const *rows )
+{
+    const size_t count = tiled_count( size );
+    size_t       i, j, width;
+
+    for( i = 0; i < size; ++i ) {
+        for( j = 0; j < size; j += TILE_SIZE ) {
+            width = ( size - j < TILE_SIZE ) ? size - j : TILE_SIZE;
+            const floating_type *segment = tiles + ( ( i / TILE_SIZE ) * count + j / TILE_SIZE ) * TILE_SIZE * TILE_SIZE + ( i % TILE_SIZE ) * TILE_SIZE;
+            memcpy( &rows[i][j], segment, width * sizeof( floating_type ) );
+        }
+    }
+}
+
+
+PUBLIC void tiled_gemm( const floating_type * restrict a, const floating_type * restrict b, floating_type * restrict c )
+{
+    size_t i, p;
+
+    // A row of C stays in L1 while it receives a multiple of every row of B.
+    for( i = 0; i < TILE_SIZE; ++i ) {
+        for( p = 0; p < TILE_SIZE; ++p ) {
+            row_axpy( TILE_SIZE, a[i * TILE_SIZE + p], &b[p * TILE_SIZE], &c[i * TILE_SIZE] );
+        }
+    }
+}
+
+
+PUBLIC void tiled_trsm( const floating_type * restrict l, floating_type * restrict b )
+{
+    size_t i, p;
+
+    for( i = 1; i < TILE_SIZE; ++i ) {
+        for( p = 0; p < i; ++p ) {
+            row_axpy( TILE_SIZE, l[i * TILE_SIZE + p], &b[p * TILE_SIZE], &b[i * TILE_SIZE] );
+        }
+    }
+}
+
+
+//! Exchanges the parts of rows r and s that lie in tile column 'column'.
+PRIVATE void tiled_swap( floating_type *tiles, size_t count, size_t column, size_t r, size_t s )
+{
+    floating_type *x = tiled_tile( tiles, count, r / TILE_SIZE, column ) + ( r % TILE_SIZE ) * TILE_SIZE;
+    floating_type *y = tiled_tile( tiles, count, s / TILE_SIZE, column ) + ( s % TILE_SIZE ) * TILE_SIZE;
+    floating_type  temp;
+
+    for( size_t j = 0; j < TILE_SIZE; ++j ) {
+        temp = x[j];
+        x[j] = y[j];
+        y[j] = temp;
+    }
+}
+
+
+//! Factors tile column 'step', recording the pivots of its columns. O(n b^2)
+PRIVATE enum GaussianResult tiled_panel( size_t size, floating_type *tiles, size_t *pivots, size_t step )
+{
+    const size_t   count = tiled_count( size );
+    const size_t   padded = count * TILE_SIZE;
+    const size_t   first = step * TILE_SIZE;
+    const size_t   last = ( size - first < TILE_SIZE ) ? size : first + TILE_SIZE;
+    floating_type *pivot, *row;
+    floating_type  m, best;
+    size_t         c, r, k, column;
+
+    GaussianProfile *profile = phase_current_profile;
+    double time = phase_clock( profile );
+
+    // The padding columns have nothing to eliminate: below the diagonal they are zero.
+    for( c = first; c < last; ++c ) {
+        column = c % TILE_SIZE;
+
+        // Find the row with the largest value of |a[r][c]|, r = c, ..., padded - 1
+        k = c;
+        best = -1.0;
+        for( r = c; r < padded; ++r ) {
+            row = tiled_tile( tiles, count, r / TILE_SIZE, step ) + ( r % TILE_SIZE ) * TILE_SIZE;
+            if( fabs( row[column] ) > best ) {
+                k = r;
+                best = fabs( row[column] );
+            }
+        }
+
+        // Check for |a[k][c]| zero.
+        // TODO: The value 1.0E-6 is arbitrary. A more disciplined value should be used.
+        if( best <= 1.0E-6 ) {
+            return gaussian_degenerate;
+        }
+        pivots[c] = k;
+        time = phase_charge( profile, 0, phase_pivot_search, time );
+
+        // Exchange row c and row k within the panel. The other tile columns follow later.
+        if( k != c ) {
+            tiled_swap( tiles, count, step, c, k );
+        }
+        time = phase_charge( profile, 0, phase_row_swap, time );
+
+        // Record the multipliers and subtract multiples of row c inside the panel only.
+        pivot = tiled_tile( tiles, count, c / TILE_SIZE, step ) + column * TILE_SIZE;
+        for( r = c + 1; r < padded; ++r ) {
+            row = tiled_tile( tiles, count, r / TILE_SIZE, step ) + ( r % TILE_SIZE ) * TILE_SIZE;
+            m = row[column] /= pivot[column];
+            row_axpy( TILE_SIZE - column - 1, m, &pivot[column + 1], &row[column + 1] );
+        }
+        time = phase_charge( profile, 0, phase_row_update, time );
+    }
+    return gaussian_success;
+}
+
+
+//! Brings the tile columns of one thread up to date with the panel of the current step.
+PRIVATE void *tiled_column_work( void *arg )
+{
+    struct TiledWorkUnit *unit = (struct TiledWorkUnit *)arg;
+
+    const size_t count = unit->count;
+    const size_t step = unit->step;
+    const size_t first = step * TILE_SIZE;
+    const size_t last = ( unit->size - first < TILE_SIZE ) ? unit->size : first + TILE_SIZE;
+    floating_type *tiles = unit->tiles;
+    double start = phase_clock( unit->profile );
+    double time = start;
+
+    for( size_t column = unit->member; column < count; column += unit->team_size ) {
+        if( column == step ) continue;
+
+        // Make the row exchanges of the panel in this column, including the multipliers to the
+        // left of the panel.
+        for( size_t c = first; c < last; ++c ) {
+            if( unit->pivots[c] != c ) {
+                tiled_swap( tiles, count, column, c, unit->pivots[c] );
+            }
+        }
+        time = phase_charge( unit->profile, unit->member, phase_row_swap, time );
+
+        // Turn the top tile into a tile of U and update the tiles below it.
+        if( column > step ) {
+            floating_type *top = tiled_tile( tiles, count, step, column );
+            tiled_trsm( tiled_tile( tiles, count, step, step ), top );
+            for( size_t row = step + 1; row < count; ++row ) {
+                tiled_gemm( tiled_tile( tiles, count, row, step ), top, tiled_tile( tiles, count, row, column ) );
+            }
+        }
+        time = phase_charge( unit->profile, unit->member, phase_row_update, time );
+    }
+
+    unit->update_time = time - start;
+    return NULL;
+}
+
+
+PUBLIC enum GaussianResult tiled_factor( size_t size, floating_type *tiles, size_t *pivots, int thread_count )
+{
+    const size_t count = tiled_count( size );
+    enum GaussianResult return_code = gaussian_success;
+
+    // There is no point in more threads than tile columns.
+    int team_size = ( (size_t)thread_count < count ) ? thread_count : (int)count;
+    if( team_size < 1 ) team_size = 1;
+
+    struct TiledWorkUnit *units = (struct TiledWorkUnit *)malloc( team_size * sizeof( struct TiledWorkUnit ) );
+    if( units == NULL ) return gaussian_error;
+
+    WorkerTeam team;
+    WorkerTeam_initialize( &team, team_size );
+    GaussianProfile *profile = phase_current_profile;
+    phase_team( profile, team_size );
+    for( int h = 0; h < team_size; ++h ) {
+        units[h].tiles = tiles;
+        units[h].pivots = pivots;
+        units[h].size = size;
+        units[h].count = count;
+        units[h].member = h;
+        units[h].team_size = team_size;
+        units[h].profile = profile;
+    }
+
+    for( size_t step = 0; step < count; ++step ) {
+        return_code = tiled_panel( size, tiles, pivots, step );
+        if( return_code != gaussian_success ) break;
+
+        // Whatever part of the round a member didn't spend on its columns went to handing out
+        // work and waiting.
+        double time = phase_clock( profile );
+        for( int h = 0; h < team_size; ++h ) {
+            units[h].step = step;
+        }
+        WorkerTeam_run( &team, tiled_column_work, units, sizeof( struct TiledWorkUnit ) );
+        if( profile != NULL ) {
+            double now = phase_clock( profile );
+            for( int h = 0; h < team_size; ++h ) {
+                phase_add( profile, h, phase_synchronization, now - time - units[h].update_time );
+            }
+        }
+    }
+
+    WorkerTeam_destroy( &team );
+    free( units );
+    return return_code;
+}
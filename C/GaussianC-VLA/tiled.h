@@ -0,0 +1,64 @@
+/*!
+ * \file   tiled.h
+ * \brief  Interface to the tile-major matrix layout and the LU factorization that works on it.
+ *
+ * In the tiled layout the matrix is cut into TILE_SIZE x TILE_SIZE tiles and each tile is stored
+ * contiguously, row after row, with the tiles themselves in row-major order. A block update then
+ * reads and writes a few whole tiles instead of TILE_SIZE pieces of rows spread over the matrix,
+ * which suits the prefetchers and needs a handful of TLB entries. A tile is also the natural unit
+ * of work to hand to a thread, or to move between memory and disk.
+ *
+ * A size x size matrix occupies tiled_count( size ) tiles on a side. Where size is not a multiple
+ * of TILE_SIZE the last tiles are padded as an identity matrix, so the kernels only ever see
+ * whole tiles and the padding factors trivially.
+ */
+
+#ifndef TILED_H
+#define TILED_H
+
+#include <stddef.h>
+
+#include "gaussian.h"
+
+// Number of rows (and columns) in a tile. Compile with -DTILE_SIZE=n to tune it for a particular
+// cache hierarchy. Three tiles should fit in the L2 cache.
+#ifndef TILE_SIZE
+#define TILE_SIZE 64
+#endif
+
+//! Returns the number of tiles on a side of a size x size matrix.
+size_t tiled_count( size_t size );
+
+//! Returns a pointer to tile (row, column) of a tiled matrix with 'count' tiles on a side.
+static inline floating_type *tiled_tile( floating_type *tiles, size_t count, size_t row, size_t column )
+{
+    return tiles + ( row * count + column ) * TILE_SIZE * TILE_SIZE;
+}
+
+//! Copies a row-major matrix into the tiled layout.
+/*!
+ * rows[i] points at row i of the matrix. 'tiles' must have room for tiled_count( size )^2 tiles;
+ * the padding is filled in here.
+ */
+void tiled_from_rows( size_t size, floating_type *const *rows, floating_type * restrict tiles );
+
+//! Copies a tiled matrix back into row-major form: row i goes to rows[i]. The padding is dropped.
+void tiled_to_rows( size_t size, const floating_type * restrict tiles, floating_type *const *rows );
+
+//! Computes C -= A * B for three tiles.
+void tiled_gemm( const floating_type * restrict a, const floating_type * restrict b, floating_type * restrict c );
+
+//! Computes B = L^-1 B, where L is the unit lower triangle of tile l.
+void tiled_trsm( const floating_type * restrict l, floating_type * restrict b );
+
+//! Factors a tiled matrix in place with partial pivoting. O(n^3)
+/*!
+ * On success the tiles hold L (below the diagonal, with a unit diagonal that is not stored) and
+ * U, with the rows in their final order, and pivots[i] is the row that was exchanged with row i
+ * at step i, as in LAPACK. Whole rows are exchanged, including the multipliers already stored.
+ * The tile updates of each step are shared among thread_count threads. Returns gaussian_error
+ * if the memory for them can't be had.
+ */
+enum GaussianResult tiled_factor( size_t size, floating_type *tiles, size_t *pivots, int thread_count );
+
+#endif
@@ -17,61 +17,71 @@
 #define PRIVATE static
 #define PUBLIC
 
-__global__ void elimination_kernel( size_t size, floating_type *a, floating_type *b, size_t i ) {
+// Rows are reached through perm: logical row j is stored in physical row perm[j] of a.
+__global__ void elimination_kernel( size_t size, floating_type *a, floating_type *b, const size_t *perm, size_t i ) {
     size_t         k;
     floating_type  m;
 
     int my_id = ( blockIdx.x * blockDim.x ) + threadIdx.x;
     int j = i + 1 + my_id;
+    size_t row_i = perm[i];
+    size_t row_j = perm[j];
     // Commented code was attempt at getting shared memory working.
     // extern __shared__ floating_type temp[];
     // temp[my_id] = MATRIX_GET( a, size, i, my_id );
     // __syncthreads();
 
-    m = MATRIX_GET( a, size, j, i ) / MATRIX_GET( a, size, i, i );
+    m = MATRIX_GET( a, size, row_j, i ) / MATRIX_GET( a, size, row_i, i );
     // m = MATRIX_GET( a, size, j, i ) / temp[i];
     for( k = 0; k < size; ++k )
-        MATRIX_PUT( a, size, j, k, MATRIX_GET( a, size, j, k ) - m * MATRIX_GET( a, size, i, k ) );
+        MATRIX_PUT( a, size, row_j, k, MATRIX_GET( a, size, row_j, k ) - m * MATRIX_GET( a, size, row_i, k ) );
         // MATRIX_PUT( a, size, j, k, MATRIX_GET( a, size, j, k ) - m * temp[k] );
     b[j] -= m * b[i];
 }
 
 //! Does the elimination step of reducing the system. O(n^3)
-PRIVATE enum GaussianResult elimination( size_t size, floating_type *a, floating_type *b )
+/*!
+ * Rows are never moved. Instead perm[i] records which row of a currently plays the role of row i
+ * and exchanging two rows exchanges two entries of perm.
+ */
+PRIVATE enum GaussianResult elimination( size_t size, floating_type *a, floating_type *b, size_t *perm )
 {
-    floating_type *temp_array = (floating_type *)malloc( size * sizeof(floating_type) );
     size_t         i, j, k;
     floating_type  temp, m;
 
-    floating_type *dev_a = MATRIX_MAKE( size );
-    floating_type *dev_b = (floating_type *)malloc( size * sizeof( floating_type ) );
+    floating_type *dev_a;
+    floating_type *dev_b;
+    size_t        *dev_perm;
     cudaMalloc( (void **)&dev_a, size * size * sizeof(double) );
     cudaMalloc( (void **)&dev_b, size * sizeof(double) );
+    cudaMalloc( (void **)&dev_perm, size * sizeof(size_t) );
 
     for( i = 0; i < size - 1; ++i ) {
 
         // Find the row with the largest value of |a[j][i]|, j = i, ..., n - 1
         k = i;
-        m = fabs( MATRIX_GET( a, size, i, i ) );
+        m = fabs( MATRIX_GET( a, size, perm[i], i ) );
         for( j = i + 1; j < size; ++j ) {
-            if( fabs( MATRIX_GET( a, size, j, i ) ) > m ) {
+            if( fabs( MATRIX_GET( a, size, perm[j], i ) ) > m ) {
                 k = j;
-                m = fabs( MATRIX_GET( a, size, j, i ) );
+                m = fabs( MATRIX_GET( a, size, perm[j], i ) );
             }
         }
 
         // Check for |a[k][i]| zero.
         // TODO: The value 1.0E-6 is arbitrary. A more disciplined value should be used.
-        if( fabs( MATRIX_GET( a, size, k, i ) ) <= 1.0E-6 ) {
-            free( temp_array );
+        if( fabs( MATRIX_GET( a, size, perm[k], i ) ) <= 1.0E-6 ) {
+            cudaFree( dev_a );
+            cudaFree( dev_b );
+            cudaFree( dev_perm );
             return gaussian_degenerate;
         }
 
-        // Exchange row i and row k, if necessary.
+        // Exchange row i and row k, if necessary. Only their entries in perm move.
         if( k != i ) {
-            memcpy( temp_array, MATRIX_GET_ROW( a, size, i ), size * sizeof( floating_type ) );
-            memcpy( MATRIX_GET_ROW( a, size, i ), MATRIX_GET_ROW( a, size, k ), size * sizeof( floating_type ) );
-            memcpy( MATRIX_GET_ROW( a, size, k ), temp_array, size * sizeof( floating_type ) );
+            j = perm[i];
+            perm[i] = perm[k];
+            perm[k] = j;
 
             // Exchange corresponding elements of b.
             temp = b[i];
@@ -81,18 +91,19 @@ PRIVATE enum GaussianResult elimination( size_t size, floating_type *a, floating
 
         cudaMemcpy( dev_a, a, size * size * sizeof(double), cudaMemcpyHostToDevice );
         cudaMemcpy( dev_b, b, size * sizeof(double), cudaMemcpyHostToDevice );
-        elimination_kernel<<<size - 1 - i, 1, size * sizeof(double)>>>( size, dev_a, dev_b, i );
+        cudaMemcpy( dev_perm, perm, size * sizeof(size_t), cudaMemcpyHostToDevice );
+        elimination_kernel<<<size - 1 - i, 1, size * sizeof(double)>>>( size, dev_a, dev_b, dev_perm, i );
         cudaMemcpy( a, dev_a, size * size * sizeof(double), cudaMemcpyDeviceToHost );
         cudaMemcpy( b, dev_b, size * sizeof(double), cudaMemcpyDeviceToHost );
     }
-    free( temp_array );
     cudaFree( dev_a );
     cudaFree( dev_b );
+    cudaFree( dev_perm );
     return gaussian_success;
 }
 
 //! Does the back substitution step of solving the system. O(n^2)
-PRIVATE enum GaussianResult back_substitution( size_t size, floating_type *a, floating_type *b )
+PRIVATE enum GaussianResult back_substitution( size_t size, floating_type *a, floating_type *b, const size_t *perm )
 {
     floating_type sum;
     size_t        i, j;
@@ -102,15 +113,15 @@ PRIVATE enum GaussianResult back_substitution( size_t size, floating_type *a, fl
     for( counter = 0; counter < size; ++counter ) {
         i = ( size - 1 ) - counter;
         // TODO: The value 1.0E-6 is arbitrary. A more disciplined value should be used.
-        if( fabs( MATRIX_GET( a, size, i, i ) ) <= 1.0E-6 ) {
+        if( fabs( MATRIX_GET( a, size, perm[i], i ) ) <= 1.0E-6 ) {
             return gaussian_degenerate;
         }
 
         sum = b[i];
         for( j = i + 1; j < size; ++j ) {
-            sum -= MATRIX_GET( a, size, i, j ) * b[j];
+            sum -= MATRIX_GET( a, size, perm[i], j ) * b[j];
         }
-        b[i] = sum / MATRIX_GET( a, size, i, i );
+        b[i] = sum / MATRIX_GET( a, size, perm[i], i );
     }
     return gaussian_success;
 }
@@ -121,8 +132,13 @@ PUBLIC enum GaussianResult gaussian_solve( size_t size, floating_type *a, floati
     // We can deal with a 1x1 system, but not an empty system.
     if( size == 0 ) return gaussian_error;
 
-    enum GaussianResult return_code = elimination( size, a, b );
+    // The rows of a are reached through this permutation, which starts out as the identity.
+    size_t *perm = (size_t *)malloc( size * sizeof( size_t ) );
+    for( size_t i = 0; i < size; ++i ) perm[i] = i;
+
+    enum GaussianResult return_code = elimination( size, a, b, perm );
     if( return_code == gaussian_success )
-        return_code = back_substitution( size, a, b );
+        return_code = back_substitution( size, a, b, perm );
+    free( perm );
     return return_code;
 }
@@ -1,14 +1,17 @@
 #define MATRIX_GET( matrix, size, row, column )        ( (matrix)[(row)*(size) + (column)] )
 #define MATRIX_PUT( matrix, size, row, column, value ) ( (matrix)[(row)*(size) + (column)] = (value) )
 
-__kernel void chunk_elimination(__global double *a, __global double *b, unsigned int size, unsigned int i) {
+// Rows are reached through perm: logical row j is stored in physical row perm[j] of a.
+__kernel void chunk_elimination(__global double *a, __global double *b, unsigned int size, unsigned int i, __global const unsigned int *perm) {
     int my_id = get_global_id( 0 );
     size_t         k;
     double  m;
     int j = i + 1 + my_id;
+    unsigned int row_i = perm[i];
+    unsigned int row_j = perm[j];
 
-    m = MATRIX_GET( a, size, j, i ) / MATRIX_GET( a, size, i, i );
+    m = MATRIX_GET( a, size, row_j, i ) / MATRIX_GET( a, size, row_i, i );
     for( k = 0; k < size; ++k )
-        MATRIX_PUT( a, size, j, k, MATRIX_GET( a, size, j, k ) - m * MATRIX_GET( a, size, i, k ) );
+        MATRIX_PUT( a, size, row_j, k, MATRIX_GET( a, size, row_j, k ) - m * MATRIX_GET( a, size, row_i, k ) );
     b[j] -= m * b[i];
 }
@@ -1,9 +1,10 @@
 #define MATRIX_GET( matrix, size, row, column )        ( (matrix)[(row)*(size) + (column)] )
 #define MATRIX_PUT( matrix, size, row, column, value ) ( (matrix)[(row)*(size) + (column)] = (value) )
 
-__kernel void chunk_elimination(__global double *a, __global double *b, unsigned int size) {
+// Rows are reached through perm: logical row j is stored in physical row perm[j] of a.
+__kernel void chunk_elimination(__global double *a, __global double *b, unsigned int size, __global unsigned int *perm) {
 
-    unsigned int    i, j, k, l;
+    unsigned int    i, j, k, row_i, row_j;
     double          temp, m;
     int my_id = get_global_id( 0 );
 
@@ -13,31 +14,26 @@ __kernel void chunk_elimination(__global double *a, __global double *b, unsigned
         if (my_id == 0) {
             // Find the row with the largest value of |a[j][i]|, j = i, ..., n - 1
             k = i;
-            m = fabs( MATRIX_GET(a, size, i, i) );
+            m = fabs( MATRIX_GET(a, size, perm[i], i) );
             for( j = i + 1; j < size; ++j ) {
-                if( fabs( MATRIX_GET(a, size, j, i) ) > m ) {
+                if( fabs( MATRIX_GET(a, size, perm[j], i) ) > m ) {
                     k = j;
-                    m = fabs( MATRIX_GET(a, size, j, i) );
+                    m = fabs( MATRIX_GET(a, size, perm[j], i) );
                 }
             }
 
             // Check for |a[k][i]| zero.
             // TODO: The value 1.0E-6 is arbitrary. A more disciplined value should be used.
-            if( fabs( MATRIX_GET(a, size, k, i) ) <= 1.0E-6 ) {
+            if( fabs( MATRIX_GET(a, size, perm[k], i) ) <= 1.0E-6 ) {
                 //free( temp_array );
                 return;
             }
 
-            // Exchange row i and row k, if necessary.
+            // Exchange row i and row k, if necessary. Only their entries in perm move.
             if( k != i ) {
-                // memcpy( temp_array, a[i], size * sizeof( double ) );
-                // memcpy( a[i], a[k], size * sizeof( double ) );
-                // memcpy( a[k], temp_array, size * sizeof( double ) );
-                for ( l = 0; l < size; l++) {
-                    temp = MATRIX_GET(a, size, i, l);
-                    MATRIX_PUT(a, size, i, l, MATRIX_GET(a, size, k, l));
-                    MATRIX_PUT(a, size, k, l, temp);
-                }
+                j = perm[i];
+                perm[i] = perm[k];
+                perm[k] = j;
 
                 // Exchange corresponding elements of b.
                 temp = b[i];
@@ -50,9 +46,11 @@ __kernel void chunk_elimination(__global double *a, __global double *b, unsigned
         barrier(CLK_GLOBAL_MEM_FENCE);
 
         j = i + 1 + my_id;
-        m = MATRIX_GET( a, size, j, i ) / MATRIX_GET( a, size, i, i );
+        row_i = perm[i];
+        row_j = perm[j];
+        m = MATRIX_GET( a, size, row_j, i ) / MATRIX_GET( a, size, row_i, i );
         for( k = 0; k < size; ++k )
-            MATRIX_PUT( a, size, j, k, MATRIX_GET( a, size, j, k ) - m * MATRIX_GET( a, size, i, k ) );
+            MATRIX_PUT( a, size, row_j, k, MATRIX_GET( a, size, row_j, k ) - m * MATRIX_GET( a, size, row_i, k ) );
         b[j] -= m * b[i];
     }
 }
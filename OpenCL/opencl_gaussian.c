@@ -20,7 +20,12 @@ enum GaussianResult {
     gaussian_degenerate   // The system is degenerate and does not have a unique solution.
 };
 
-enum GaussianResult elimination( size_t size, floating_type (* restrict a)[size], floating_type * restrict b )
+//! Does the elimination step of reducing the system. O(n^3)
+/*!
+ * Rows are never moved. Instead perm[i] records which row of a currently plays the role of row i
+ * and exchanging two rows exchanges two entries of perm.
+ */
+enum GaussianResult elimination( size_t size, floating_type (* restrict a)[size], floating_type * restrict b, cl_uint * restrict perm )
 {
 
     cl_uint platform_count = 0;
@@ -55,6 +60,8 @@ enum GaussianResult elimination( size_t size, floating_type (* restrict a)[size]
     if( status != CL_SUCCESS ) fprintf( stderr, "Error creating bufA!\n" );
     cl_mem bufB = clCreateBuffer( context, CL_MEM_READ_WRITE,  datasize, NULL, &status );
     if( status != CL_SUCCESS ) fprintf( stderr, "Error creating bufB!\n" );
+    cl_mem bufPerm = clCreateBuffer( context, CL_MEM_READ_WRITE,  sizeof(cl_uint) * size, NULL, &status );
+    if( status != CL_SUCCESS ) fprintf( stderr, "Error creating bufPerm!\n" );
 
 
     char *programSource;
@@ -103,35 +110,33 @@ enum GaussianResult elimination( size_t size, floating_type (* restrict a)[size]
     cl_kernel kernel = clCreateKernel( program, "chunk_elimination", &status );
     if( status != CL_SUCCESS ) fprintf( stderr, "Error creating kernel!\n" );
 
-    //floating_type *temp_array = (floating_type *)malloc( size * sizeof(floating_type) );
-    floating_type  temp_array[size];
     size_t         i, j, k;
+    cl_uint        row;
     floating_type  temp, m;
 
     for( i = 0; i < size - 1; ++i ) {
 
         // Find the row with the largest value of |a[j][i]|, j = i, ..., n - 1
         k = i;
-        m = fabs( a[i][i] );
+        m = fabs( a[perm[i]][i] );
         for( j = i + 1; j < size; ++j ) {
-            if( fabs( a[j][i] ) > m ) {
+            if( fabs( a[perm[j]][i] ) > m ) {
                 k = j;
-                m = fabs( a[j][i] );
+                m = fabs( a[perm[j]][i] );
             }
         }
 
         // Check for |a[k][i]| zero.
         // TODO: The value 1.0E-6 is arbitrary. A more disciplined value should be used.
-        if( fabs( a[k][i] ) <= 1.0E-6 ) {
-            //free( temp_array );
+        if( fabs( a[perm[k]][i] ) <= 1.0E-6 ) {
             return gaussian_degenerate;
         }
 
-        // Exchange row i and row k, if necessary.
+        // Exchange row i and row k, if necessary. Only their entries in perm move.
         if( k != i ) {
-            memcpy( temp_array, a[i], size * sizeof( floating_type ) );
-            memcpy( a[i], a[k], size * sizeof( floating_type ) );
-            memcpy( a[k], temp_array, size * sizeof( floating_type ) );
+            row = perm[i];
+            perm[i] = perm[k];
+            perm[k] = row;
 
             // Exchange corresponding elements of b.
             temp = b[i];
@@ -144,6 +149,8 @@ enum GaussianResult elimination( size_t size, floating_type (* restrict a)[size]
         if( status != CL_SUCCESS ) fprintf( stderr, "Error copying bufA to Device! Error code: %d\n", status );
         status = clEnqueueWriteBuffer( cmdQueue, bufB, CL_TRUE, 0, datasize, b, 0, NULL, NULL );
         if( status != CL_SUCCESS ) fprintf( stderr, "Error copying bufB to Device! Error code: %d\n", status );
+        status = clEnqueueWriteBuffer( cmdQueue, bufPerm, CL_TRUE, 0, sizeof(cl_uint) * size, perm, 0, NULL, NULL );
+        if( status != CL_SUCCESS ) fprintf( stderr, "Error copying bufPerm to Device! Error code: %d\n", status );
 
         // Set the kernel arguments.
         cl_uint cl_size = size;
@@ -156,6 +163,8 @@ enum GaussianResult elimination( size_t size, floating_type (* restrict a)[size]
         if( status != CL_SUCCESS ) fprintf( stderr, "Error adding argument 2! Error code: %d\n", status );
         status = clSetKernelArg( kernel, 3, sizeof(cl_uint), &cl_i );
         if( status != CL_SUCCESS ) fprintf( stderr, "Error adding argument 3! Error code: %d\n", status );
+        status = clSetKernelArg( kernel, 4, sizeof(cl_mem), &bufPerm );
+        if( status != CL_SUCCESS ) fprintf( stderr, "Error adding argument 4! Error code: %d\n", status );
 
         // Define an index space of work items for execution.
         size_t indexSpaceSize[1], workGroupSize[1];
@@ -174,7 +183,6 @@ enum GaussianResult elimination( size_t size, floating_type (* restrict a)[size]
         status = clEnqueueReadBuffer( cmdQueue, bufB, CL_TRUE, 0, datasize, b, 0, NULL, NULL );
         if( status != CL_SUCCESS ) fprintf( stderr, "Error copying bufB to Host! Error code: %d\n", status );
     }
-    //free( temp_array );
 
     // Free OpenCL resources.
     clReleaseKernel( kernel );
@@ -182,12 +190,13 @@ enum GaussianResult elimination( size_t size, floating_type (* restrict a)[size]
     clReleaseCommandQueue( cmdQueue );
     clReleaseMemObject( bufA );
     clReleaseMemObject( bufB );
+    clReleaseMemObject( bufPerm );
     clReleaseContext( context );
 
     return gaussian_success;
 }
 
-enum GaussianResult full_gpu_elimination( size_t size, floating_type (* restrict a)[size], floating_type * restrict b )
+enum GaussianResult full_gpu_elimination( size_t size, floating_type (* restrict a)[size], floating_type * restrict b, cl_uint * restrict perm )
 {
 
     cl_uint platform_count = 0;
@@ -222,6 +231,8 @@ enum GaussianResult full_gpu_elimination( size_t size, floating_type (* restrict
     if( status != CL_SUCCESS ) fprintf( stderr, "Error creating bufA!\n" );
     cl_mem bufB = clCreateBuffer( context, CL_MEM_READ_WRITE,  datasize, NULL, &status );
     if( status != CL_SUCCESS ) fprintf( stderr, "Error creating bufB!\n" );
+    cl_mem bufPerm = clCreateBuffer( context, CL_MEM_READ_WRITE,  sizeof(cl_uint) * size, NULL, &status );
+    if( status != CL_SUCCESS ) fprintf( stderr, "Error creating bufPerm!\n" );
 
 
     char *programSource;
@@ -275,6 +286,8 @@ enum GaussianResult full_gpu_elimination( size_t size, floating_type (* restrict
     if( status != CL_SUCCESS ) fprintf( stderr, "Error copying bufA to Device! Error code: %d\n", status );
     status = clEnqueueWriteBuffer( cmdQueue, bufB, CL_TRUE, 0, datasize, b, 0, NULL, NULL );
     if( status != CL_SUCCESS ) fprintf( stderr, "Error copying bufB to Device! Error code: %d\n", status );
+    status = clEnqueueWriteBuffer( cmdQueue, bufPerm, CL_TRUE, 0, sizeof(cl_uint) * size, perm, 0, NULL, NULL );
+    if( status != CL_SUCCESS ) fprintf( stderr, "Error copying bufPerm to Device! Error code: %d\n", status );
 
     // Set the kernel arguments.
     cl_uint cl_size = size;
@@ -284,6 +297,8 @@ enum GaussianResult full_gpu_elimination( size_t size, floating_type (* restrict
     if( status != CL_SUCCESS ) fprintf( stderr, "Error adding argument 1! Error code: %d\n", status );
     status = clSetKernelArg( kernel, 2, sizeof(cl_uint), &cl_size );
     if( status != CL_SUCCESS ) fprintf( stderr, "Error adding argument 2! Error code: %d\n", status );
+    status = clSetKernelArg( kernel, 3, sizeof(cl_mem), &bufPerm );
+    if( status != CL_SUCCESS ) fprintf( stderr, "Error adding argument 3! Error code: %d\n", status );
     // status = clSetKernelArg( kernel, 2, size * sizeof(cl_double), NULL );
     // if( status != CL_SUCCESS ) fprintf( stderr, "Error adding argument 2! Error code: %d\n", status );
 
@@ -303,7 +318,8 @@ enum GaussianResult full_gpu_elimination( size_t size, floating_type (* restrict
     if( status != CL_SUCCESS ) fprintf( stderr, "Error copying bufA to Host! Error code: %d\n", status );
     status = clEnqueueReadBuffer( cmdQueue, bufB, CL_TRUE, 0, datasize, b, 0, NULL, NULL );
     if( status != CL_SUCCESS ) fprintf( stderr, "Error copying bufB to Host! Error code: %d\n", status );
-    //free( temp_array );
+    status = clEnqueueReadBuffer( cmdQueue, bufPerm, CL_TRUE, 0, sizeof(cl_uint) * size, perm, 0, NULL, NULL );
+    if( status != CL_SUCCESS ) fprintf( stderr, "Error copying bufPerm to Host! Error code: %d\n", status );
 
     // Free OpenCL resources.
     clReleaseKernel( kernel );
@@ -311,13 +327,14 @@ enum GaussianResult full_gpu_elimination( size_t size, floating_type (* restrict
     clReleaseCommandQueue( cmdQueue );
     clReleaseMemObject( bufA );
     clReleaseMemObject( bufB );
+    clReleaseMemObject( bufPerm );
     clReleaseContext( context );
 
     return gaussian_success;
 }
 
 //! Does the back substitution step of solving the system. O(n^2)
-enum GaussianResult back_substitution( size_t size, floating_type (* __restrict__ a)[size], floating_type * __restrict__ b )
+enum GaussianResult back_substitution( size_t size, floating_type (* __restrict__ a)[size], floating_type * __restrict__ b, const cl_uint * __restrict__ perm )
 {
     floating_type sum;
     size_t        i, j;
@@ -327,15 +344,15 @@ enum GaussianResult back_substitution( size_t size, floating_type (* __restrict_
     for( counter = 0; counter < size; ++counter ) {
         i = ( size - 1 ) - counter;
         // TODO: The value 1.0E-6 is arbitrary. A more disciplined value should be used.
-        if( fabs( a[i][i] ) <= 1.0E-6 ) {
+        if( fabs( a[perm[i]][i] ) <= 1.0E-6 ) {
             return gaussian_degenerate;
         }
 
         sum = b[i];
         for( j = i + 1; j < size; ++j ) {
-            sum -= a[i][j] * b[j];
+            sum -= a[perm[i]][j] * b[j];
         }
-        b[i] = sum / a[i][i];
+        b[i] = sum / a[perm[i]][i];
     }
     return gaussian_success;
 }
@@ -345,9 +362,14 @@ enum GaussianResult gaussian_solve( size_t size, floating_type (* __restrict__ a
     // We can deal with a 1x1 system, but not an empty system.
     if( size == 0 ) return gaussian_error;
 
-    enum GaussianResult return_code = elimination( size, a, b );
-    return_code = back_substitution( size, a, b );
+    // The rows of a are reached through this permutation, which starts out as the identity.
+    cl_uint *perm = (cl_uint *)malloc( size * sizeof( cl_uint ) );
+    for( size_t i = 0; i < size; ++i ) perm[i] = i;
 
+    enum GaussianResult return_code = elimination( size, a, b, perm );
+    return_code = back_substitution( size, a, b, perm );
+
+    free( perm );
     return return_code;
 }
 